@@ -7,11 +7,30 @@
 #include <Region.hpp>
 #include <ProgressBar.hpp>
 #include <Logger.hpp>
+#include <ChunkSchema.hpp>
 
 const std::string ChunkModifier::assetsPath = std::filesystem::current_path().string() + "/assets/";
 
+// everything else stays encoded and is only decoded if a modifier accesses it,
+// untouched subtrees (entities, heightmaps, light...) are written back verbatim
+const std::vector<std::string> ChunkModifier::decodedPaths = { "DataVersion", "Level.Sections.Y", "sections.Y" };
 
-void ChunkModifier::loadAVGColor(std::string filename, const std::function<void(color, const std::string&)>& insert) {
+const uint16_t ChunkModifier::airBlock = BlockRegistry::id("minecraft:air");
+
+
+const SectionCodec* ChunkModifier::findCodec(NBT& root) {
+	NBTcompound* compound = root.try_get<NBTcompound>();
+	const int32_t* dataVersion = compound ? ChunkSchema::DataVersion.find(*compound) : nullptr;
+	const SectionCodec* codec = dataVersion ? SectionCodec::forDataVersion(*dataVersion) : nullptr;
+
+	if (!codec)
+		Logger::error("[chunk_error] unsupported DataVersion " + (dataVersion ? std::to_string(*dataVersion) : std::string("none")) + ", chunk is left unchanged");
+
+	return codec;
+}
+
+
+void ChunkModifier::loadAVGColor(std::string filename, const std::function<void(color, uint16_t)>& insert) {
 
 	const size_t lastSlash = filename.find_last_of("\\/");
 	if (lastSlash == std::string::npos)
@@ -62,7 +81,7 @@ void ChunkModifier::loadAVGColor(std::string filename, const std::function<void(
 			outBuffer += line + "\n";
 		}
 
-		insert(avgColor, blockID);
+		insert(avgColor, BlockRegistry::id(blockID));
 	}
 
 	fileIn.close();
@@ -75,12 +94,29 @@ void ChunkModifier::loadAVGColor(std::string filename, const std::function<void(
 	}
 }
 
-void ChunkModifier::reassembleRegions(LockableQueue<Chunk>* inputBuffer, std::string outputDir, uint64_t numChunks, bool* active) {
+void ChunkModifier::reassembleRegions(LockableQueue<Chunk>* inputBuffer, std::string inputDir, std::string outputDir, uint64_t numChunks, bool* active) {
 
 	Logger::debug("|K:::|Gstarting |Yassembler|K:::");
 
 	std::vector<Region> regions;
 
+	const auto saveRegion = [&inputDir, &outputDir](Region& region) {
+		const std::string filename = "r." + std::to_string(region.x) + "." + std::to_string(region.z) + ".mca";
+
+		if (region.modified()) {
+			region.saveMCA(outputDir + filename);
+			return;
+		}
+
+		// every chunk is the one of the input file, which is kept byte for byte
+		std::error_code error;
+		if (std::filesystem::equivalent(inputDir + filename, outputDir + filename, error)) {
+			Logger::debug("region " + filename + " is unchanged");
+		} else if (!std::filesystem::copy_file(inputDir + filename, outputDir + filename, std::filesystem::copy_options::overwrite_existing, error)) {
+			Logger::error("[region_error] cannot copy unchanged region " + filename + ": " + error.message());
+		}
+	};
+
 	ProgressBar progress("modifying regions", 60, "\u001b[33;1m");
 	uint64_t numReceivedChunks = 0;
 
@@ -115,7 +151,7 @@ void ChunkModifier::reassembleRegions(LockableQueue<Chunk>* inputBuffer, std::st
 			regionIt->chunks.push_back(std::move(*chunk));
 
 			if (regionIt->chunks.size() == 1024) {
-				regions[0].saveMCA(outputDir + "r." + std::to_string(regions[0].x) + "." + std::to_string(regions[0].z) + ".mca");
+				saveRegion(*regionIt);
 				regions.erase(regionIt);
 			}
 		}
@@ -126,7 +162,7 @@ void ChunkModifier::reassembleRegions(LockableQueue<Chunk>* inputBuffer, std::st
 	Logger::debug("\nflushing regionBuffer...");
 
 	while (regions.size() > 0) {
-		regions[0].saveMCA(outputDir + "r." + std::to_string(regions[0].x) + "." + std::to_string(regions[0].z) + ".mca");
+		saveRegion(regions[0]);
 		regions.erase(regions.begin());
 	}
 
@@ -10,19 +10,27 @@
 #include <functional>
 #include <vf3.hpp>
 #include <mcBoundingBox.hpp>
+#include <SectionCodec.hpp>
+#include <BlockRegistry.hpp>
 
 
 class ChunkModifier {
 protected:
 	const mcBoundingBox workingVolume;
 	static const std::string assetsPath;
+	static const std::vector<std::string> decodedPaths;
+	static const uint16_t airBlock;
+
+	// codec for the DataVersion of the chunk or nullptr (after logging) if it is not supported
+	static const SectionCodec* findCodec(NBT& root);
 
 public:
 	ChunkModifier(const mcBoundingBox& _workingVolume) : workingVolume{ _workingVolume } {}
 
 	virtual void modifyChunk(Chunk&) = 0;
 
-	static void loadAVGColor(std::string filename, const std::function<void(color, const std::string&)>& insert);
+	static void loadAVGColor(std::string filename, const std::function<void(color, uint16_t)>& insert);
 
-	static void reassembleRegions(LockableQueue<Chunk>* inputBuffer, std::string outputDir, uint64_t numChunks, bool* active);
+	// regions without modified chunks are not rewritten, only copied from 'inputDir' if the output goes elsewhere
+	static void reassembleRegions(LockableQueue<Chunk>* inputBuffer, std::string inputDir, std::string outputDir, uint64_t numChunks, bool* active);
 };
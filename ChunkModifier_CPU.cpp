@@ -3,13 +3,22 @@
 #include <vd3.hpp>
 #include <ProgressBar.hpp>
 #include <Logger.hpp>
-#include <TriangleBoxIntersection.h>
+#include <ChunkSchema.hpp>
+#include <TriangleBoxBatch.hpp>
+#include <BlockRegistry.hpp>
+#include <PalettedSection.hpp>
 
-ChunkModifier* ChunkModifier_CPU::init(OBJ& model, const mcBoundingBox& workingVolume) {
+#include <algorithm>
+#include <cmath>
+#include <thread>
 
-	ColorLookup<std::string> blocksByColor;
+ChunkModifier* ChunkModifier_CPU::init(OBJ& model, const mcBoundingBox& workingVolume, uint32_t) {
+
+	BlockRegistry::loadList(assetsPath + "blockIDlists/itemLookup.txt");
+
+	ColorLookup<uint16_t> blocksByColor;
 	ChunkModifier::loadAVGColor(assetsPath + "blockIDlists/blocks.txt", 
-		std::bind(&ColorLookup<std::string>::insert, &blocksByColor, std::placeholders::_1, std::placeholders::_2));
+		std::bind(&ColorLookup<uint16_t>::insert, &blocksByColor, std::placeholders::_1, std::placeholders::_2));
 
 	std::vector<pointerTriangle> triangles = model.createTriangleBuffer();
 
@@ -17,167 +26,258 @@ ChunkModifier* ChunkModifier_CPU::init(OBJ& model, const mcBoundingBox& workingV
 		throw std::runtime_error("[obj_error] no triangles found");
 
 	for (material& material : model.getMaterials()) {
-		if (material.blockID.length() == 0) {
+		if (material.blockID == BlockRegistry::none) {
 			material.blockID = blocksByColor.get(material.c);
 		}
 	}
 	const std::vector<Image>& textures = model.getTextures();
 
-	return new ChunkModifier_CPU(workingVolume, std::move(triangles), textures, std::move(blocksByColor));
-}
+	const uint32_t numThreads = std::thread::hardware_concurrency();
 
+	// textured voxels find their block in the quantized color table instead of comparing every color
+	blocksByColor.buildTable(numThreads);
 
-void ChunkModifier_CPU::modifyChunk(Chunk& chunk) {
-	Logger::debug("|Bchunk |W" + std::to_string(chunk.x) + " " + std::to_string(chunk.z));
+	Logger::log("preparing " + std::to_string(triangles.size()) + " triangles");
+	Logger::debug(std::string("using the ") + TriangleBoxBatch::name(TriangleBoxBatch::select()) + " triangle box test");
+
+	std::vector<PreparedTriangle> prepared = PreparedTriangle::prepare(triangles, numThreads);
+
+	// binned by the centers of the first and last voxel they touch, so the bins match the voxel ranges exactly
+	TriangleBins bins(workingVolume, static_cast<uint32_t>(prepared.size()), [&prepared](uint32_t index, vf3& min, vf3& max) {
+		const PreparedTriangle& triangle = prepared[index];
+		min = vf3(triangle.voxelMin[0] + 0.5f, triangle.voxelMin[1] + 0.5f, triangle.voxelMin[2] + 0.5f);
+		max = vf3(triangle.voxelMax[0] + 0.5f, triangle.voxelMax[1] + 0.5f, triangle.voxelMax[2] + 0.5f);
+	}, numThreads);
+
+	bool anyTextured = false, anyFlat = false;
+	for (const PreparedTriangle& triangle : prepared)
+		(triangle.textured() ? anyTextured : anyFlat) = true;
+
+	const MeshShading shading = anyTextured ? (anyFlat ? MeshShading::Mixed : MeshShading::Textured) : MeshShading::Flat;
+
+	return new ChunkModifier_CPU(workingVolume, std::move(prepared), std::move(bins), textures, std::move(blocksByColor), shading);
+}
 
-	if (chunk.compressed)
-		chunk.uncompress();
 
-	NBT root = chunk.getNBT();
-	chunk.clean();
+template<MeshShading shading>
+void ChunkModifier_CPU::insertTriangles(const std::vector<uint32_t>& columnTriangles, const int columnOrigin[3], int numSections, SectionPatch* patches, uint64_t* written) const {
 
-	NBTcompound& level = root["Level"];
-	level["xPos"] = chunk.x / 16;
-	level["zPos"] = chunk.z / 16;
+	// covers rounding errors of the slab bounds, the separating axis test decides
+	const float epsilon = 1e-4f;
 
-	NBTlist& sections = level["Sections"];
-				
-	for (size_t sectionY = workingVolume.minSectionY; sectionY < workingVolume.maxSectionY; sectionY++) try {
+	const int columnMax[3] = { 15, numSections * 16 - 1, 15 };
 
-		const vf3 sectionMin(static_cast<float>(chunk.x), sectionY * 16.0f, static_cast<float>(chunk.z));
-		const vf3 sectionMax = sectionMin + vf3(16.0f, 16.0f, 16.0f);
+	// one 4x4x4 brick mask per section, bit bx + bz * 4 + (by % 4) * 16
+	std::vector<uint64_t> brickMasks(static_cast<size_t>(numSections));
 
-		std::vector<const pointerTriangle*> sectionTriangles;
+	// candidates are confirmed in batches of up to one section
+	uint32_t candidates[4096];
+	float centerX[4096], centerY[4096], centerZ[4096];
+	uint8_t overlaps[4096];
 
-		for (size_t i = 0; i < triangles.size(); i++)
-			if (approxTriBoxOverlap(triangles[i].vertices, sectionMin, sectionMax))
-				sectionTriangles.push_back(&triangles[i]);
+	for (const uint32_t triangleIndex : columnTriangles) {
+		const PreparedTriangle& triangle = triangles[triangleIndex];
 
-		if (sectionTriangles.size() == 0)
+		// column relative voxel range of the triangle and the offset of the column to the triangle's anchor
+		int voxelMin[3], voxelMax[3], offset[3];
+		bool outside = false;
+		for (int axis = 0; axis < 3; axis++) {
+			voxelMin[axis] = std::max(triangle.voxelMin[axis] - columnOrigin[axis], 0);
+			voxelMax[axis] = std::min(triangle.voxelMax[axis] - columnOrigin[axis], columnMax[axis]);
+			offset[axis] = columnOrigin[axis] - triangle.anchor[axis];
+			outside |= voxelMin[axis] > voxelMax[axis];
+		}
+		if (outside)
 			continue;
-	
-		auto setctionIt = sections.end();
 
-		for (auto it = sections.begin(); it != sections.end(); it++) {
-			if (it->at<int8_t>("Y") == sectionY) {
-				setctionIt = it;
-				break;
+		//------------------------/ bricks /------------------------//
+
+		const int brickMin[3] = { voxelMin[0] >> 2, voxelMin[1] >> 2, voxelMin[2] >> 2 };
+		const int brickMax[3] = { voxelMax[0] >> 2, voxelMax[1] >> 2, voxelMax[2] >> 2 };
+		const bool singleBrick = brickMin[0] == brickMax[0] && brickMin[1] == brickMax[1] && brickMin[2] == brickMax[2];
+
+		bool anyBrick = false;
+		for (int sectionIndex = brickMin[1] >> 2; sectionIndex <= brickMax[1] >> 2; sectionIndex++)
+			brickMasks[sectionIndex] = 0;
+
+		for (int by = brickMin[1]; by <= brickMax[1]; by++) {
+			for (int bz = brickMin[2]; bz <= brickMax[2]; bz++) {
+				for (int bx = brickMin[0]; bx <= brickMax[0]; bx++) {
+					const vf3 brickCenter(
+						static_cast<float>(bx * 4 + 2 + offset[0]),
+						static_cast<float>(by * 4 + 2 + offset[1]),
+						static_cast<float>(bz * 4 + 2 + offset[2])
+					);
+					// the voxel test decides alone if there is only one brick
+					if (singleBrick || triangle.overlapsBrick(brickCenter)) {
+						brickMasks[by >> 2] |= uint64_t(1) << (bx + bz * 4 + (by & 3) * 16);
+						anyBrick = true;
+					}
+				}
 			}
 		}
 
-		if (setctionIt == sections.end()) {
-			sections.push_back(NBTcompound{
-				{ "Y", (int8_t)sectionY },
-				{ "BlockLight", NBTbyteArray(2048, 1) }
-			});
+		if (!anyBrick)
+			continue;
 
-			setctionIt = --sections.end();
-		}
-		NBTcompound& section = *setctionIt;
+		//------------------------/ confirm and write /------------------------//
 
+		size_t numCandidates = 0;
 
-		if (section.find("Palette") == section.end()) {
-			section.insert({ "Palette", NBTlist{} });
-		}
-		NBTlist& palette = section["Palette"];
+		// instantiated once per kind of triangle, so the loop carries no branch on the material
+		const auto write = [&](auto textured) {
+			overlapKernel(triangle, centerX, centerY, centerZ, numCandidates, overlaps);
 
-		if (section.find("BlockStates") == section.end()) {
-			section.insert({ "BlockStates", NBTlongArray(256, 0) });
-		}
-		NBTlongArray& blocks = section["BlockStates"];
+			for (size_t i = 0; i < numCandidates; i++) {
+				if (!overlaps[i])
+					continue;
 
-		if (blocks.size() == 0) {
-			blocks.resize(256, 0);
-		}
+				const uint32_t index = candidates[i];
+				SectionPatch& patch = patches[index >> 12];
+
+				if constexpr (decltype(textured)::value) {
 
-		//------------------------/ extract blockStates /------------------------//
+					float u, v;
+					triangle.texCoord(vf3(centerX[i], centerY[i], centerZ[i]), u, v);
 
-		const uint32_t bitsPerBlock = static_cast<uint32_t>(std::max(std::ceil(log2(palette.size())), 4.0));
-		const uint8_t blocksPerLong = 64 / bitsPerBlock;
+					patch.push(static_cast<uint16_t>(index & 4095), blockIDtoColor.get(textures[triangle.m->texIndex](u, v)));
 
-		const auto findOrAddBlock = [&palette](const std::string& blockName) {
-			for (size_t i = 0; i < palette.size(); i++) {
-				if (static_cast<const std::string&>(palette[i]["Name"]) == blockName) {
-					return (uint16_t)i;
+				} else {
+					patch.push(static_cast<uint16_t>(index & 4095), triangle.m->blockID);
 				}
+
+				written[index >> 6] |= uint64_t(1) << (index & 63);
 			}
-			palette.push_back(NBTcompound{ { "Name", blockName } });
-			return static_cast<uint16_t>(palette.size() - 1);
+
+			numCandidates = 0;
 		};
 
-		findOrAddBlock("minecraft:air");
+		// only meshes that mix both kinds of triangles decide per triangle
+		const bool textured = shading == MeshShading::Textured || (shading == MeshShading::Mixed && triangle.textured());
 
-		uint16_t blockIndices[4096];
+		const auto flush = [&]() {
+			if (textured)
+				write(std::true_type{});
+			else
+				write(std::false_type{});
+		};
 
-		const int64_t mask = INT64_MAX >> (64 - bitsPerBlock);
-		for (uint32_t i = 0; i < 4096; i++)
-			blockIndices[i] = static_cast<uint16_t>((blocks[i / blocksPerLong] >> (bitsPerBlock * (i % blocksPerLong))) & mask);
+		//------------------------/ voxels /------------------------//
+
+		// walk the two axes the plane is most parallel to and only visit the voxels its slab passes along the third
+		const vf3& normal = triangle.normal;
+		const float absN[3] = { std::abs(normal.x), std::abs(normal.y), std::abs(normal.z) };
+		const int d = absN[0] > absN[1] ? (absN[0] > absN[2] ? 0 : 2) : (absN[1] > absN[2] ? 1 : 2);
+		const int a = (d + 1) % 3;
+		const int b = (d + 2) % 3;
+
+		const float nd = (&normal.x)[d];
+		const float slopeA = nd != 0.0f ? -(&normal.x)[a] / nd : 0.0f;
+		const float slopeB = nd != 0.0f ? -(&normal.x)[b] / nd : 0.0f;
+		const vf3& origin = triangle.vertices[0];
+
+		int voxel[3];
+		for (voxel[a] = voxelMin[a]; voxel[a] <= voxelMax[a]; voxel[a]++) {
+			const float a0 = slopeA * (static_cast<float>(voxel[a] + offset[a]) - (&origin.x)[a]);
+			const float a1 = a0 + slopeA;
+
+			for (voxel[b] = voxelMin[b]; voxel[b] <= voxelMax[b]; voxel[b]++) {
+				int first = voxelMin[d], last = voxelMax[d];
+
+				if (nd != 0.0f) {
+					const float b0 = slopeB * (static_cast<float>(voxel[b] + offset[b]) - (&origin.x)[b]);
+					const float b1 = b0 + slopeB;
+					const float planeMin = (&origin.x)[d] + std::min(a0, a1) + std::min(b0, b1);
+					const float planeMax = (&origin.x)[d] + std::max(a0, a1) + std::max(b0, b1);
+					first = std::max(first, static_cast<int>(std::ceil(planeMin - epsilon)) - 1 - offset[d]);
+					last = std::min(last, static_cast<int>(std::floor(planeMax + epsilon)) - offset[d]);
+				}
 
-		//------------------------/ insert object /------------------------//
+				for (voxel[d] = first; voxel[d] <= last; voxel[d]++) {
+					// YZX order, the sections of the column follow each other
+					const uint32_t index = static_cast<uint32_t>(voxel[0] + voxel[2] * 16 + voxel[1] * 256);
+					if ((written[index >> 6] >> (index & 63)) & 1)
+						continue;
+					if (!((brickMasks[voxel[1] >> 4] >> ((voxel[0] >> 2) + (voxel[2] >> 2) * 4 + ((voxel[1] >> 2) & 3) * 16)) & 1))
+						continue;
+
+					candidates[numCandidates] = index;
+					centerX[numCandidates] = static_cast<float>(voxel[0] + offset[0]) + 0.5f;
+					centerY[numCandidates] = static_cast<float>(voxel[1] + offset[1]) + 0.5f;
+					centerZ[numCandidates] = static_cast<float>(voxel[2] + offset[2]) + 0.5f;
+
+					if (++numCandidates == 4096)
+						flush();
+				}
+			}
+		}
 
-		const float dim = 1.0f;
-		const vf3 boxSize(dim, dim, dim);
-		const vf3 boxHalfsize = boxSize * 0.5f;
-		const vf3 boxMiddle(0.5f, 0.5f, 0.5f);
+		flush();
+	}
+}
 
-		for (uint8_t x = 0; x < 16; x++) {
-			for (uint8_t y = 0; y < 16; y++) {
-				for (uint8_t z = 0; z < 16; z++) {
 
-					const vf3 box_pos(static_cast<float>(chunk.x + x), sectionY * 16.0f + y, static_cast<float>(chunk.z + z));
-					const vf3 box_center = box_pos + boxMiddle;
+void ChunkModifier_CPU::modifyChunk(Chunk& chunk) {
+	Logger::debug("|Bchunk |W" + std::to_string(chunk.x) + " " + std::to_string(chunk.z));
 
-					for (const pointerTriangle* triangle : sectionTriangles) {
-						if (approxTriBoxOverlap(triangle->vertices, box_pos, box_pos + boxSize) &&
-							triBoxOverlap(box_center, boxHalfsize, *(triangle->vertices[0]), *(triangle->vertices[1]), *(triangle->vertices[2]))
-							) {
+	const int chunkX = chunk.x / 16;
+	const int chunkZ = chunk.z / 16;
 
-							if (triangle->m && triangle->m->texIndex != -1) {
+	// chunks without triangles are passed on without being decoded
+	const auto columnRange = bins.sectionRange(chunkX, chunkZ);
+	if (columnRange.first == columnRange.second)
+		return;
 
-								const vd3 s(*(triangle->vertices[1]) - *(triangle->vertices[0]));
-								const vd3 t(*(triangle->vertices[2]) - *(triangle->vertices[0]));
-								const vd3 n = s.cross(t);
+	NBT root = chunk.getNBT(decodedPaths, true);
 
-								const vd3 delta(box_center - *(triangle->vertices[0]));
+	const SectionCodec* codec = findCodec(root);
+	if (!codec)
+		return;
 
-								const double invDet = 1.0 / n.dot(n);
-								const double w = s.cross(delta).dot(n) * invDet;
-								const double v = delta.cross(t).dot(n) * invDet;
-								const double u = 1.0 - w - v;
+	const int minSectionY = std::max<int>(columnRange.first, codec->minSectionY);
+	const int maxSectionY = std::min<int>(columnRange.second, codec->maxSectionY);
 
-								blockIndices[x + z * 16 + y * 256] = findOrAddBlock(blockIDtoColor.get(textures[triangle->m->texIndex](
-									u* triangle->texCoords[0]->x + v * triangle->texCoords[1]->x + w * triangle->texCoords[2]->x,
-									u* triangle->texCoords[0]->y + v * triangle->texCoords[1]->y + w * triangle->texCoords[2]->y
-								)));
+	if (minSectionY >= maxSectionY)
+		return;
 
-							} else {
-								blockIndices[x + z * 16 + y * 256] = findOrAddBlock(triangle->m->blockID);
-							}
+	ChunkSections sections(root, *codec);
+	sections.setPosition(chunkX, chunkZ);
 
-							break;
-						}
-					}
-				}
-			}
-		}
+	const int numSections = maxSectionY - minSectionY;
+	const size_t numVoxels = 4096ULL * numSections;
 
-		//------------------------/ update blockStates /------------------------//
+	//------------------------/ insert object /------------------------//
 
-		const uint32_t new_bitsPerBlock = static_cast<uint32_t>(std::max(std::ceil(log2(palette.size())), 4.0));
-		const uint32_t new_blocksPerLong = 64 / new_bitsPerBlock;
-		const uint32_t new_blockArraySize = static_cast<uint32_t>(std::ceil(4096.0f / new_blocksPerLong));
+	// the blocks written by the model per section and a bit per voxel that marks them
+	std::vector<SectionPatch> patches(static_cast<size_t>(numSections));
+	std::vector<uint64_t> written(numVoxels / 64, 0);
 
-		blocks.resize(new_blockArraySize);
-		std::fill(blocks.begin(), blocks.end(), 0);
+	// triangle indices in model order, so the first overlapping triangle still wins
+	std::vector<uint32_t> columnTriangles;
+	bins.column(chunkX, chunkZ, columnTriangles);
 
-		for (size_t i = 0; i < 4096; i++) {
-			blocks[i / new_blocksPerLong] |= static_cast<int64_t>(blockIndices[i]) << ((i % new_blocksPerLong) * new_bitsPerBlock);
-		}
+	const int columnOrigin[3] = { chunk.x, minSectionY * 16, chunk.z };
+
+	switch (shading) {
+	case MeshShading::Flat: insertTriangles<MeshShading::Flat>(columnTriangles, columnOrigin, numSections, patches.data(), written.data()); break;
+	case MeshShading::Textured: insertTriangles<MeshShading::Textured>(columnTriangles, columnOrigin, numSections, patches.data(), written.data()); break;
+	case MeshShading::Mixed: insertTriangles<MeshShading::Mixed>(columnTriangles, columnOrigin, numSections, patches.data(), written.data()); break;
+	}
+
+	//------------------------/ apply patches /------------------------//
+
+	// untouched voxels keep their slot, and with it the block's properties
+	bool changed = false;
+
+	for (int sectionY = minSectionY; sectionY < maxSectionY; sectionY++) try {
+
+		changed |= PalettedSection::apply(sections, static_cast<int8_t>(sectionY), patches[sectionY - minSectionY], airBlock);
 
 	} catch (const std::exception& e) {
 		Logger::error(std::string("Error while modifiyng section: ") + e.what());
-
 	}
 
-	chunk.setNBT(root);
+	// a chunk the model leaves as it was keeps its compressed data
+	if (changed)
+		chunk.setNBT(root, true);
 }
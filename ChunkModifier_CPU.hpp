@@ -5,25 +5,42 @@
 #include <LockableQueue.hpp>
 #include <OBJ.hpp>
 #include <ColorLookup.hpp>
+#include <PreparedTriangle.hpp>
+#include <TriangleBins.hpp>
+#include <TriangleBoxBatch.hpp>
+#include <PalettedSection.hpp>
 
 
 class ChunkModifier_CPU : public ChunkModifier {
 private:
-	const std::vector<pointerTriangle> triangles;
+	const std::vector<PreparedTriangle> triangles;
+	const TriangleBins bins;
 	const std::vector<Image>& textures;
-	const ColorLookup<std::string> blockIDtoColor;
+	const ColorLookup<uint16_t> blockIDtoColor;
+	const TriangleBoxBatch::Kernel overlapKernel;
+	const MeshShading shading;
+
+	// adds the block IDs of the triangles to the patches of a column of 'numSections' sections
+	// and marks the voxels in 'written', instantiated per mesh shading
+	template<MeshShading>
+	void insertTriangles(const std::vector<uint32_t>& columnTriangles, const int columnOrigin[3], int numSections, SectionPatch* patches, uint64_t* written) const;
 
 public:
 	ChunkModifier_CPU(const mcBoundingBox& workingVolume, 
-		std::vector<pointerTriangle>&& _triangles,
+		std::vector<PreparedTriangle>&& _triangles,
+		TriangleBins&& _bins,
 		const std::vector<Image>& _textures, 
-		ColorLookup<std::string>&& lookup) : 
+		ColorLookup<uint16_t>&& lookup,
+		MeshShading _shading) : 
 			ChunkModifier{ workingVolume },
 			triangles{ std::move(_triangles) },
+			bins{ std::move(_bins) },
 			textures{ _textures },
-			blockIDtoColor{ std::move(lookup) }{}
+			blockIDtoColor{ std::move(lookup) },
+			overlapKernel{ TriangleBoxBatch::select() },
+			shading{ _shading } {}
 
-	static ChunkModifier* init(OBJ&, const mcBoundingBox&);
+	static ChunkModifier* init(OBJ&, const mcBoundingBox&, uint32_t numWorkers);
 
 	void modifyChunk(Chunk&) override;
 };
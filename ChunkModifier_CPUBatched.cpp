@@ -0,0 +1,231 @@
+#include "ChunkModifier_CPUBatched.hpp"
+
+#include <Logger.hpp>
+#include <ChunkSchema.hpp>
+#include <BlockRegistry.hpp>
+#include <PalettedSection.hpp>
+
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <thread>
+
+ChunkModifier* ChunkModifier_CPUBatched::init(OBJ& model, const mcBoundingBox& workingVolume, uint32_t numWorkers) {
+
+	BlockRegistry::loadList(assetsPath + "blockIDlists/itemLookup.txt");
+
+	ColorLookup<uint16_t> blocksByColor;
+	ChunkModifier::loadAVGColor(assetsPath + "blockIDlists/blocks.txt", 
+		std::bind(&ColorLookup<uint16_t>::insert, &blocksByColor, std::placeholders::_1, std::placeholders::_2));
+
+	std::vector<pointerTriangle> triangles = model.createTriangleBuffer();
+
+	if (triangles.size() == 0)
+		throw std::runtime_error("[obj_error] no triangles found");
+
+	for (material& material : model.getMaterials()) {
+		if (material.blockID == BlockRegistry::none) {
+			material.blockID = blocksByColor.get(material.c);
+		}
+	}
+	const std::vector<Image>& textures = model.getTextures();
+
+	const uint32_t numThreads = std::thread::hardware_concurrency();
+
+	// textured voxels find their block in the quantized color table instead of comparing every color
+	blocksByColor.buildTable(numThreads);
+
+	Logger::log("preparing " + std::to_string(triangles.size()) + " triangles");
+	Logger::debug(std::string("using the ") + TriangleBoxBatch::name(TriangleBoxBatch::select()) + " triangle box test");
+
+	std::vector<PreparedTriangle> prepared = PreparedTriangle::prepare(triangles, numThreads);
+
+	TriangleBins bins(workingVolume, static_cast<uint32_t>(prepared.size()), [&prepared](uint32_t index, vf3& min, vf3& max) {
+		const PreparedTriangle& triangle = prepared[index];
+		min = vf3(triangle.voxelMin[0] + 0.5f, triangle.voxelMin[1] + 0.5f, triangle.voxelMin[2] + 0.5f);
+		max = vf3(triangle.voxelMax[0] + 0.5f, triangle.voxelMax[1] + 0.5f, triangle.voxelMax[2] + 0.5f);
+	}, numThreads);
+
+	const uint32_t poolThreads = numThreads > numWorkers ? numThreads - numWorkers : 0;
+	Logger::debug("cpu-batched pool with " + std::to_string(poolThreads) + " threads next to " + std::to_string(numWorkers) + " workers");
+
+	return new ChunkModifier_CPUBatched(workingVolume, std::move(prepared), std::move(bins), textures, std::move(blocksByColor), poolThreads);
+}
+
+
+void ChunkModifier_CPUBatched::insertBlocks(size_t block, const std::vector<uint32_t>& columnTriangles, uint16_t* blockBuffer, int chunkX, int minSectionY, int chunkZ) const {
+
+	// a block covers 4 layers of a section, voxel i of the buffer lies at (i % 16, i / 256, i / 16 % 16) in the column
+	const size_t firstIndex = block * voxelsPerBlock;
+	const int minY = static_cast<int>(firstIndex / 256);
+	const int blockOrigin[3] = { chunkX * 16, minSectionY * 16 + minY, chunkZ * 16 };
+	const int blockMax[3] = { 15, static_cast<int>(voxelsPerBlock / 256) - 1, 15 };
+
+	// voxels that already took a triangle, the kernel's break
+	std::bitset<voxelsPerBlock> written;
+
+	uint16_t candidates[voxelsPerBlock];
+	float centerX[voxelsPerBlock], centerY[voxelsPerBlock], centerZ[voxelsPerBlock];
+	uint8_t overlaps[voxelsPerBlock];
+
+	for (const uint32_t triangleIndex : columnTriangles) {
+		const PreparedTriangle& triangle = triangles[triangleIndex];
+
+		// integer bounds replace the approximate float test
+		int voxelMin[3], voxelMax[3], offset[3];
+		bool outside = false;
+		for (int axis = 0; axis < 3; axis++) {
+			voxelMin[axis] = std::max(triangle.voxelMin[axis] - blockOrigin[axis], 0);
+			voxelMax[axis] = std::min(triangle.voxelMax[axis] - blockOrigin[axis], blockMax[axis]);
+			offset[axis] = blockOrigin[axis] - triangle.anchor[axis];
+			outside |= voxelMin[axis] > voxelMax[axis];
+		}
+		if (outside)
+			continue;
+
+		size_t numCandidates = 0;
+
+		for (int y = voxelMin[1]; y <= voxelMax[1]; y++) {
+			for (int z = voxelMin[2]; z <= voxelMax[2]; z++) {
+				for (int x = voxelMin[0]; x <= voxelMax[0]; x++) {
+					const uint16_t index = static_cast<uint16_t>(x + z * 16 + y * 256);
+					if (written[index])
+						continue;
+
+					candidates[numCandidates] = index;
+					centerX[numCandidates] = static_cast<float>(x + offset[0]) + 0.5f;
+					centerY[numCandidates] = static_cast<float>(y + offset[1]) + 0.5f;
+					centerZ[numCandidates] = static_cast<float>(z + offset[2]) + 0.5f;
+					numCandidates++;
+				}
+			}
+		}
+
+		if (numCandidates == 0)
+			continue;
+
+		overlapKernel(triangle, centerX, centerY, centerZ, numCandidates, overlaps);
+
+		const auto write = [&](auto textured) {
+			for (size_t i = 0; i < numCandidates; i++) {
+				if (!overlaps[i])
+					continue;
+
+				const uint16_t index = candidates[i];
+
+				if constexpr (decltype(textured)::value) {
+
+					float u, v;
+					triangle.texCoord(vf3(centerX[i], centerY[i], centerZ[i]), u, v);
+
+					blockBuffer[firstIndex + index] = blockIDtoColor.get(textures[triangle.m->texIndex](u, v));
+
+				} else {
+					blockBuffer[firstIndex + index] = triangle.m->blockID;
+				}
+
+				written.set(index);
+			}
+		};
+
+		if (triangle.textured())
+			write(std::true_type{});
+		else
+			write(std::false_type{});
+
+		if (written.all())
+			break;
+	}
+}
+
+
+void ChunkModifier_CPUBatched::modifyChunk(Chunk& chunk) {
+
+	Logger::debug("|Bchunk |W" + std::to_string(chunk.x) + " " + std::to_string(chunk.z));
+
+	//------------------------/ pre-filter triangles /------------------------//
+
+	const int chunkX = chunk.x / 16;
+	const int chunkZ = chunk.z / 16;
+
+	const auto columnRange = bins.sectionRange(chunkX, chunkZ);
+	if (columnRange.first == columnRange.second)
+		return;
+
+	std::vector<uint32_t> columnTriangles;
+	bins.column(chunkX, chunkZ, columnTriangles);
+
+	try {
+
+		NBT root = chunk.getNBT(decodedPaths, true);
+
+		const SectionCodec* codec = findCodec(root);
+		if (!codec)
+			return;
+
+		// the block buffer only spans the sections of the column holding triangles
+		const int minSectionY = std::max<int>(columnRange.first, codec->minSectionY);
+		const int maxSectionY = std::min<int>(columnRange.second, codec->maxSectionY);
+
+		if (minSectionY >= maxSectionY)
+			return;
+
+		ChunkSections sections(root, *codec);
+		sections.setPosition(chunkX, chunkZ);
+
+		//------------------------/ init blockBuffer /------------------------//
+
+		const size_t numSections = static_cast<size_t>(maxSectionY - minSectionY);
+		std::vector<uint16_t> blockBuffer(4096ULL * numSections);
+
+		// palette and palette indices of every section, the buffer holds the block ID of each voxel
+		std::vector<std::unique_ptr<PalettedSection>> paletted(numSections);
+
+		for (int sectionY = minSectionY; sectionY < maxSectionY; sectionY++) {
+
+			ChunkSections::Section& section = sections.getOrCreate(static_cast<int8_t>(sectionY));
+			std::unique_ptr<PalettedSection>& sectionPalette = paletted[sectionY - minSectionY];
+			sectionPalette = std::make_unique<PalettedSection>(sections, section, airBlock);
+
+			uint16_t* sectionBlocks = &blockBuffer[static_cast<size_t>(sectionY - minSectionY) * 4096ULL];
+
+			for (size_t i = 0; i < 4096; i++)
+				sectionBlocks[i] = sectionPalette->blockID(i);
+		}
+
+		//------------------------/ convert /------------------------//
+
+		const size_t numBlocks = blockBuffer.size() / voxelsPerBlock;
+
+		pool.parallelFor(numBlocks, [&](size_t block) {
+			insertBlocks(block, columnTriangles, blockBuffer.data(), chunkX, minSectionY, chunkZ);
+		});
+
+		//------------------------/ update blocks /------------------------//
+
+		bool changed = false;
+
+		for (int sectionY = minSectionY; sectionY < maxSectionY; sectionY++) {
+
+			PalettedSection& sectionPalette = *paletted[sectionY - minSectionY];
+			const uint16_t* sectionBlocks = &blockBuffer[static_cast<size_t>(sectionY - minSectionY) * 4096ULL];
+
+			bool sectionChanged = false;
+			for (size_t i = 0; i < 4096; i++)
+				sectionChanged |= sectionPalette.setBlock(i, sectionBlocks[i]);
+
+			// sections the model leaves as they were keep their block states
+			if (sectionChanged)
+				sectionPalette.encode();
+
+			changed |= sectionChanged;
+		}
+
+		// a chunk the model leaves as it was keeps its compressed data
+		if (changed)
+			chunk.setNBT(root, true);
+
+	} catch (const std::exception& e) {
+		Logger::error(e.what());
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "ChunkModifier.hpp"
+
+#include <LockableQueue.hpp>
+#include <OBJ.hpp>
+#include <ColorLookup.hpp>
+#include <PreparedTriangle.hpp>
+#include <TriangleBins.hpp>
+#include <TriangleBoxBatch.hpp>
+#include <ThreadPool.hpp>
+
+// CPU port of the CUDA backend: the sections of a column are flattened into one buffer of block IDs
+// that is split into blocks of 1024 voxels like the kernel's thread blocks. The blocks run on a
+// thread pool, each voxel takes the first triangle of the column that overlaps it.
+class ChunkModifier_CPUBatched : public ChunkModifier {
+private:
+	static const constexpr size_t voxelsPerBlock = 1024;
+
+	const std::vector<PreparedTriangle> triangles;
+	const TriangleBins bins;
+	const std::vector<Image>& textures;
+	const ColorLookup<uint16_t> blockIDtoColor;
+	const TriangleBoxBatch::Kernel overlapKernel;
+	ThreadPool pool;
+
+	// CPU version of CUDA::insertBlocks for the voxels of one block
+	void insertBlocks(size_t block, const std::vector<uint32_t>& columnTriangles, uint16_t* blockBuffer, int chunkX, int minSectionY, int chunkZ) const;
+
+public:
+	ChunkModifier_CPUBatched(const mcBoundingBox& workingVolume,
+		std::vector<PreparedTriangle>&& _triangles,
+		TriangleBins&& _bins,
+		const std::vector<Image>& _textures,
+		ColorLookup<uint16_t>&& lookup,
+		uint32_t poolThreads) :
+			ChunkModifier{ workingVolume },
+			triangles{ std::move(_triangles) },
+			bins{ std::move(_bins) },
+			textures{ _textures },
+			blockIDtoColor{ std::move(lookup) },
+			overlapKernel{ TriangleBoxBatch::select() },
+			pool{ poolThreads } {}
+
+	// 'numWorkers' threads call modifyChunk at once and work on their own loops,
+	// the pool only gets the cores they leave
+	static ChunkModifier* init(OBJ&, const mcBoundingBox&, uint32_t numWorkers);
+
+	void modifyChunk(Chunk&) override;
+};
@@ -3,67 +3,58 @@
 #include <iostream>
 #include <fstream>
 #include <bitset>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <memory>
 
 #include <ProgressBar.hpp>
 #include <vd3.hpp>
 #include <TriangleBoxIntersection.h>
 #include <Logger.hpp>
 #include <NBT.hpp>
+#include <ChunkSchema.hpp>
+#include <BlockRegistry.hpp>
+#include <PalettedSection.hpp>
 
 
 ChunkModifier_GPU::ChunkModifier_GPU(const mcBoundingBox& workingVolume,
 	std::vector<Vec3>&& _vertices,
 	std::vector<Triangle>&& _triangles,
+	TriangleBins&& _bins,
 	cudaTextureObject_t* _texture,
-	const std::string* _blockIDLookup,
-	size_t _numBlockIDs)
-	: ChunkModifier{ workingVolume }, vertices(std::move(_vertices)), triangles(std::move(_triangles)),
-	texture{ _texture }, blockIDLookup{ _blockIDLookup }, numBlockIDs{ _numBlockIDs } {}
+	MeshShading _shading)
+	: ChunkModifier{ workingVolume }, vertices(std::move(_vertices)), triangles(std::move(_triangles)), bins(std::move(_bins)),
+	texture{ _texture }, shading{ _shading } {}
 
 
 ChunkModifier_GPU::~ChunkModifier_GPU() {
 
 	Logger::warn("Destructor called");
-	delete[] blockIDLookup;
 
 	checkCUDA(cudaDestroyTextureObject(*texture));
 
 	CUDA::freeVertexBuffer();
 	CUDA::freeTexCoordBuffer();
 	CUDA::freeTriangleBuffer();
+	CUDA::freeVoxelBoundsBuffer();
 	CUDA::freeLookupColorBuffer();
 	CUDA::freeLookupIndexBuffer();
 }
 
-ChunkModifier* ChunkModifier_GPU::init(OBJ& object, const mcBoundingBox& workingVolume) {
+ChunkModifier* ChunkModifier_GPU::init(OBJ& object, const mcBoundingBox& workingVolume, uint32_t) {
 
-	std::string blockIDFilename = assetsPath + "blockIDlists/itemLookup.txt";
+	BlockRegistry::loadList(assetsPath + "blockIDlists/itemLookup.txt");
 
-	std::ifstream fileIn(blockIDFilename);
-
-	if (!fileIn)
-		throw std::runtime_error("[block_parser_error] cannot find file \"" + blockIDFilename + "\"");
-
-	std::vector<std::string> blockIDs;
-	std::string line;
-	while (std::getline(fileIn, line)) {
-		blockIDs.push_back(line);
-	}
-
-	size_t numBlockIDs = blockIDs.size();
-	std::string* blockIDLookup = new std::string[numBlockIDs];
-	std::copy(blockIDs.begin(), blockIDs.end(), blockIDLookup);
-
-	Logger::warn(std::to_string(numBlockIDs));
+	Logger::debug("registered " + std::to_string(BlockRegistry::size()) + " block IDs");
 
 	//------------------------/ calc avg-Color /------------------------//
 
 	Logger::log("calculating texture average color");
 
 	ColorLookup<uint16_t> blocksByColor;
-	ChunkModifier::loadAVGColor(assetsPath + "blockIDlists/blocks.txt", [&](color avgColor, const std::string& blockID) {
-		blocksByColor.insert(avgColor, binSearch(blockIDLookup, numBlockIDs, blockID));
-	});
+	ChunkModifier::loadAVGColor(assetsPath + "blockIDlists/blocks.txt", 
+		std::bind(&ColorLookup<uint16_t>::insert, &blocksByColor, std::placeholders::_1, std::placeholders::_2));
 
 	Logger::debug("using " + std::to_string(blocksByColor.size()) + " different blocks");
 
@@ -84,10 +75,10 @@ ChunkModifier* ChunkModifier_GPU::init(OBJ& object, const mcBoundingBox& working
 	for (size_t i = 0; i < materials.size(); i++) {
 		if (materials[i].texIndex != -1) {
 			materialBlockIDs[i] = -1;
-		} else if (materials[i].blockID.length() == 0) {
+		} else if (materials[i].blockID == BlockRegistry::none) {
 			materialBlockIDs[i] = blocksByColor.get(materials[i].c);
 		} else {
-			materialBlockIDs[i] = binSearch(blockIDLookup, numBlockIDs, materials[i].blockID);
+			materialBlockIDs[i] = materials[i].blockID;
 		}
 	}
 
@@ -102,8 +93,40 @@ ChunkModifier* ChunkModifier_GPU::init(OBJ& object, const mcBoundingBox& working
 
 	delete[] materialBlockIDs;
 
+	bool anyTextured = false, anyFlat = false;
+	for (const Triangle& triangle : triangles)
+		(triangle.blockID == UINT16_MAX ? anyTextured : anyFlat) = true;
+
+	const MeshShading shading = anyTextured ? (anyFlat ? MeshShading::Mixed : MeshShading::Textured) : MeshShading::Flat;
+
 	CUDA::initTriangleBuffer(triangles);
 
+	Logger::debug("binning triangles");
+
+	// the voxels a triangle's bounds touch, checked by the kernel before the exact test
+	std::vector<VoxelBounds> voxelBounds(triangles.size());
+	for (size_t i = 0; i < triangles.size(); i++) {
+		const Vec3* v[3];
+		for (int j = 0; j < 3; j++)
+			v[j] = &vertices[triangles[i].vertexIndices[j]];
+
+		const float min[3] = { std::min({ v[0]->x, v[1]->x, v[2]->x }), std::min({ v[0]->y, v[1]->y, v[2]->y }), std::min({ v[0]->z, v[1]->z, v[2]->z }) };
+		const float max[3] = { std::max({ v[0]->x, v[1]->x, v[2]->x }), std::max({ v[0]->y, v[1]->y, v[2]->y }), std::max({ v[0]->z, v[1]->z, v[2]->z }) };
+
+		for (int axis = 0; axis < 3; axis++) {
+			voxelBounds[i].min[axis] = static_cast<int>(std::ceil(min[axis])) - 1;
+			voxelBounds[i].max[axis] = static_cast<int>(std::floor(max[axis]));
+		}
+	}
+
+	CUDA::initVoxelBoundsBuffer(voxelBounds);
+
+	TriangleBins bins(workingVolume, static_cast<uint32_t>(triangles.size()), [&voxelBounds](uint32_t index, vf3& min, vf3& max) {
+		const VoxelBounds& bounds = voxelBounds[index];
+		min = vf3(bounds.min[0] + 0.5f, bounds.min[1] + 0.5f, bounds.min[2] + 0.5f);
+		max = vf3(bounds.max[0] + 0.5f, bounds.max[1] + 0.5f, bounds.max[2] + 0.5f);
+	}, std::thread::hardware_concurrency());
+
 	Logger::debug("init texture atlas");
 
 	object.packTextures();
@@ -111,9 +134,7 @@ ChunkModifier* ChunkModifier_GPU::init(OBJ& object, const mcBoundingBox& working
 	std::vector<Image>& textures = object.getTextures();
 	cudaTextureObject_t* texture = CUDA::createTexture(textures[0]);
 
-	CUDA::setMinChunkY(workingVolume.minSectionY);
-
-	return new ChunkModifier_GPU(workingVolume, std::move(vertices), std::move(triangles), texture, blockIDLookup, numBlockIDs);
+	return new ChunkModifier_GPU(workingVolume, std::move(vertices), std::move(triangles), std::move(bins), texture, shading);
 }
 
 
@@ -123,110 +144,55 @@ void ChunkModifier_GPU::modifyChunk(Chunk& chunk) {
 
 	//------------------------/ pre-filter triangles /------------------------//
 
-	const Vec3 sectionMin{ static_cast<float>(chunk.x), 0.0f, static_cast<float>(chunk.z) };
-	const Vec3 sectionMax{ sectionMin.x + 16.0f, 256.0f, sectionMin.z + 16.0f };
+	const int chunkX = chunk.x / 16;
+	const int chunkZ = chunk.z / 16;
 
-	std::vector<size_t> chunkIndexBuffer;
+	std::vector<uint32_t> columnTriangles;
+	bins.column(chunkX, chunkZ, columnTriangles);
 
-	for (size_t i = 0; i < triangles.size(); i++) {
-		if (approxTriBoxOverlap2D(sectionMin, sectionMax, vertices[triangles[i].vertexIndices[0]], vertices[triangles[i].vertexIndices[1]], vertices[triangles[i].vertexIndices[2]])) {
-			chunkIndexBuffer.push_back(i);
-		}
-	}
+	const std::vector<size_t> chunkIndexBuffer(columnTriangles.begin(), columnTriangles.end());
+	const auto columnRange = bins.sectionRange(chunkX, chunkZ);
 
 	if (chunkIndexBuffer.size() > 0) try {
 
-		if (chunk.compressed)
-			chunk.uncompress();
-
-		NBT root = chunk.getNBT();
-		chunk.clean();
+		NBT root = chunk.getNBT(decodedPaths, true);
 
-		NBT& level = root["Level"];
-		level["xPos"] = chunk.x / 16;
-		level["zPos"] = chunk.z / 16;
+		const SectionCodec* codec = findCodec(root);
+		if (!codec)
+			return;
 
-		NBTlist& sections = level["Sections"];
+		// the block buffer only spans the sections of the column holding triangles
+		const int minSectionY = std::max<int>(columnRange.first, codec->minSectionY);
+		const int maxSectionY = std::min<int>(columnRange.second, codec->maxSectionY);
 
-		//------------------------/ extract blocks /------------------------//
+		if (minSectionY >= maxSectionY)
+			return;
 
-		const auto findOrAddBlock = [](NBTlist& palette, const std::string& blockName) {
-			for (size_t i = 0; i < palette.size(); i++) {
-				if (static_cast<const std::string&>(palette[i]["Name"]) == blockName) {
-					return (uint16_t)i;
-				}
-			}
-			palette.push_back(NBTcompound{ { "Name", blockName } });
-			return static_cast<uint16_t>(palette.size() - 1);
-		};
+		ChunkSections sections(root, *codec);
+		sections.setPosition(chunkX, chunkZ);
 
 		//------------------------/ init blockBuffer /------------------------//
 
 		uint16_t* device_blockBuffer = 0;
 		size_t* device_indexBuffer = 0;
 
-		const size_t numSections = workingVolume.maxSectionY - workingVolume.minSectionY + 1ULL;
+		const size_t numSections = static_cast<size_t>(maxSectionY - minSectionY);
 		const size_t blockBufferSize = 4096ULL * numSections * sizeof(uint16_t);
 		uint16_t* blockBuffer = new uint16_t[blockBufferSize];
 
-		for (size_t sectionY = workingVolume.minSectionY; sectionY <= workingVolume.maxSectionY; sectionY++) {
-
-			auto setctionIt = sections.end();
-
-			for (auto it = sections.begin(); it != sections.end(); it++) {
-				if (it->at<int8_t>("Y") == sectionY) {
-					setctionIt = it;
-					break;
-				}
-			}
+		// palette and palette indices of every section, the buffer holds the block ID of each voxel
+		std::vector<std::unique_ptr<PalettedSection>> paletted(numSections);
 
-			if (setctionIt == sections.end()) {
-				sections.push_back(NBTcompound{
-					{ "Y", (int8_t)sectionY },
-					{ "BlockLight", NBTbyteArray(2048, 1) }
-					});
+		for (int sectionY = minSectionY; sectionY < maxSectionY; sectionY++) {
 
-				setctionIt = --sections.end();
-			}
-			NBTcompound& section = *setctionIt;
+			ChunkSections::Section& section = sections.getOrCreate(static_cast<int8_t>(sectionY));
+			std::unique_ptr<PalettedSection>& sectionPalette = paletted[sectionY - minSectionY];
+			sectionPalette = std::make_unique<PalettedSection>(sections, section, airBlock);
 
+			uint16_t* sectionBlocks = &blockBuffer[static_cast<size_t>(sectionY - minSectionY) * 4096ULL];
 
-			if (section.find("Palette") == section.end()) {
-				section.insert({ "Palette", NBTlist{} });
-			}
-			NBTlist& palette = section["Palette"];
-
-			if (section.find("BlockStates") == section.end()) {
-				section.insert({ "BlockStates", NBTlongArray(256, 0) });
-			}
-			NBTlongArray& blocks = section["BlockStates"];
-
-			if (blocks.size() == 0) {
-				blocks.resize(256, 0);
-			}
-
-			const size_t bitsPerBlock = static_cast<size_t>(std::max(std::ceil(log2(palette.size())), 4.0));
-			const size_t blocksPerLong = 64 / bitsPerBlock;
-
-			findOrAddBlock(palette, "minecraft:air");
-
-			//------------------------/ create palette lookup /------------------------//
-
-			const size_t absoluteIndex = sectionY - workingVolume.minSectionY;
-
-			const size_t paletteSize = palette.size();
-			uint16_t* indexPalette = new uint16_t[paletteSize];
-
-			for (size_t i = 0; i < paletteSize; i++)
-				indexPalette[i] = (uint16_t)binSearch(blockIDLookup, numBlockIDs, palette[i]["Name"]);
-
-			//------------------------/ getColors /------------------------//
-
-			const int64_t mask = INT64_MAX >> (64 - bitsPerBlock);
 			for (size_t i = 0; i < 4096; i++)
-				blockBuffer[absoluteIndex * 4096ULL + i] = static_cast<uint16_t>(indexPalette[(blocks[i / blocksPerLong] >> (bitsPerBlock * (i % blocksPerLong))) & mask]);
-
-			delete[] indexPalette;
+				sectionBlocks[i] = sectionPalette->blockID(i);
 		}
 
 		//------------------------/ copy to gpu /------------------------//
@@ -244,7 +210,7 @@ void ChunkModifier_GPU::modifyChunk(Chunk& chunk) {
 
 
 		//pls check if texture gets copied
-		CUDA::insertBlocks(numBlocks, numThreads, device_indexBuffer, chunkIndexBuffer.size(), *texture, device_blockBuffer, chunk.x / 16, chunk.z / 16);
+		CUDA::insertBlocks(numBlocks, numThreads, shading, device_indexBuffer, chunkIndexBuffer.size(), *texture, device_blockBuffer, chunkX, minSectionY, chunkZ);
 
 		checkCUDA(cudaDeviceSynchronize());
 
@@ -258,60 +224,31 @@ void ChunkModifier_GPU::modifyChunk(Chunk& chunk) {
 
 		//------------------------/ update blocks /------------------------//
 
-		for (size_t sectionY = workingVolume.minSectionY; sectionY < workingVolume.maxSectionY; sectionY++) {
-
-			auto setctionIt = sections.end();
+		bool changed = false;
 
-			for (auto it = sections.begin(); it != sections.end(); it++) {
-				if (static_cast<int8_t>((*it)["Y"]) == sectionY) {
-					setctionIt = it;
-					break;
-				}
-			}
+		for (int sectionY = minSectionY; sectionY < maxSectionY; sectionY++) {
 
-			NBTcompound& section = *setctionIt;
+			PalettedSection& sectionPalette = *paletted[sectionY - minSectionY];
+			const uint16_t* sectionBlocks = &blockBuffer[static_cast<size_t>(sectionY - minSectionY) * 4096ULL];
 
-			NBTlist& palette = section["Palette"];
-
-			const size_t new_bitsPerBlock = static_cast<size_t>(std::max(std::ceil(log2(palette.size())), 4.0));
-			const size_t new_blocksPerLong = 64 / new_bitsPerBlock;
-			const size_t new_blockArraySize = static_cast<size_t>(std::ceil(4096.0f / new_blocksPerLong));
-
-			NBTlongArray& blocks = section["BlockStates"];
-
-			blocks.resize(new_blockArraySize);
-			std::fill(blocks.begin(), blocks.end(), 0);
+			bool sectionChanged = false;
+			for (size_t i = 0; i < 4096; i++)
+				sectionChanged |= sectionPalette.setBlock(i, sectionBlocks[i]);
 
-			const size_t absoluteIndex = (sectionY - workingVolume.minSectionY) * 4096ULL;
+			// sections the model leaves as they were keep their block states
+			if (sectionChanged)
+				sectionPalette.encode();
 
-			for (size_t i = 0; i < 4096; i++) {
-				int64_t paletteIndex = static_cast<int64_t>(findOrAddBlock(palette, blockIDLookup[blockBuffer[absoluteIndex + i]]));
-				blocks[i / new_blocksPerLong] |= paletteIndex << ((i % new_blocksPerLong) * new_bitsPerBlock);
-			}
+			changed |= sectionChanged;
 		}
 
 		delete[] blockBuffer;
 
-		chunk.setNBT(root);
+		// a chunk the model leaves as it was keeps its compressed data
+		if (changed)
+			chunk.setNBT(root, true);
 
 	} catch (const std::exception& e) {
 		Logger::error(e.what());
 	}
 }
-
-uint16_t ChunkModifier_GPU::binSearch(const std::string* values, size_t numValues, const std::string& key) {
-	uint16_t left = 0;
-	uint16_t right = numValues - 1;
-
-	while (left <= right) {
-		size_t middle = (static_cast<size_t>(left) + static_cast<size_t>(right)) / 2;
-		int offset = key.compare(values[middle]);
-
-		if (offset == 0) return static_cast<uint16_t>(middle);
-
-		if (offset > 0) left = middle + 1;
-		else right = middle - 1;
-	}
-
-	return UINT16_MAX;
-}
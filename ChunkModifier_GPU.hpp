@@ -5,31 +5,28 @@
 #include <ColorLookup.hpp>
 #include <LockableQueue.hpp>
 #include <OBJ.hpp>
+#include <TriangleBins.hpp>
 #include "kernel.cuh"
 
 class ChunkModifier_GPU : public ChunkModifier{
 private:
 	std::vector<Vec3> vertices;
 	std::vector<Triangle> triangles;
+	const TriangleBins bins;
 	cudaTextureObject_t* texture;
-
-	const std::string* blockIDLookup;
-	size_t numBlockIDs;
-
+	const MeshShading shading;
 
 public:
 	ChunkModifier_GPU(const mcBoundingBox& workingVolume,
 		std::vector<Vec3>&& _vertices,
 		std::vector<Triangle>&& _triangles,
+		TriangleBins&& _bins,
 		cudaTextureObject_t* _texture,
-		const std::string* _blockIDLookup,
-		size_t _numBlockIDs);
+		MeshShading _shading);
 
 	~ChunkModifier_GPU();
 
-	static ChunkModifier* init(OBJ& object, const mcBoundingBox& workingVolume);
+	static ChunkModifier* init(OBJ& object, const mcBoundingBox& workingVolume, uint32_t numWorkers);
 
 	void modifyChunk(Chunk&) override;
-	
-	static uint16_t binSearch(const std::string* values, const size_t numValues, const std::string& key);
 };
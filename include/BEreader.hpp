@@ -0,0 +1,88 @@
+#pragma once
+
+#include <bitset>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+// Big endian input stream over a buffer that is refilled by the source implementation.
+// When the buffered bytes run out 'underflow' either fails (plain memory) or pulls in the next
+// block (e.g. from an inflate stream), so parsers can consume their input while it is produced.
+class BEreader {
+protected:
+	const uint8_t* buffer;
+	size_t bufferSize;
+	size_t index;
+
+	BEreader() : buffer(nullptr), bufferSize(0), index(0) {}
+
+	// has to make at least 'required' bytes available starting at 'index' or throw
+	virtual void underflow(size_t required) = 0;
+
+public:
+	BEreader(const BEreader&) = delete;
+	BEreader& operator=(const BEreader&) = delete;
+
+	virtual ~BEreader() = default;
+
+	template<typename T>
+	BEreader& operator>>(T& dst) {
+		if (index + sizeof(T) > bufferSize)
+			underflow(sizeof(T));
+
+		uint8_t* bytes = reinterpret_cast<uint8_t*>(&dst);
+		for (size_t i = sizeof(T); i > 0; bytes[--i] = buffer[index++]);
+		return *this;
+	}
+
+	void read(uint8_t* dst, size_t len) {
+		while (len > 0) {
+			if (index == bufferSize)
+				underflow(1);
+
+			const size_t numBytes = std::min(len, bufferSize - index);
+			std::memcpy(dst, &buffer[index], numBytes);
+			index += numBytes;
+			dst += numBytes;
+			len -= numBytes;
+		}
+	}
+
+	void skip(size_t len) {
+		while (len > 0) {
+			if (index == bufferSize)
+				underflow(1);
+
+			const size_t numBytes = std::min(len, bufferSize - index);
+			index += numBytes;
+			len -= numBytes;
+		}
+	}
+};
+
+template<>
+inline BEreader& BEreader::operator>>(std::string& dst) {
+	uint16_t length;
+	*this >> length;
+
+	dst.resize(length);
+	read(reinterpret_cast<uint8_t*>(&dst[0]), length);
+
+	return *this;
+}
+
+
+// Reads from a buffer that is completely held in memory.
+class BEbufferReader : public BEreader {
+protected:
+	void underflow(size_t required) override {
+		throw std::out_of_range("[read_error] size: " + std::to_string(bufferSize) + " index: " + std::to_string(index + required));
+	}
+
+public:
+	BEbufferReader(const uint8_t* input, const size_t inputLen) {
+		buffer = input;
+		bufferSize = inputLen;
+	}
+};
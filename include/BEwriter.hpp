@@ -0,0 +1,103 @@
+#pragma once
+
+#include <bitset>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+// Big endian output stream over a buffer that is refilled by the sink implementation.
+// When the buffer runs full 'overflow' either grows it or drains it (e.g. into a deflate stream),
+// so serializers can write their output in a single pass without knowing its size up front.
+class BEwriter {
+protected:
+	uint8_t* buffer;
+	size_t bufferSize;
+	size_t index;
+
+	BEwriter() : buffer(nullptr), bufferSize(0), index(0) {}
+
+	// has to make room for at least one byte, ideally for 'required' bytes
+	virtual void overflow(size_t required) = 0;
+
+public:
+	BEwriter(const BEwriter&) = delete;
+	BEwriter& operator=(const BEwriter&) = delete;
+
+	virtual ~BEwriter() = default;
+
+	template<typename T>
+	BEwriter& operator<<(const T& src) {
+		if (index + sizeof(T) > bufferSize)
+			overflow(sizeof(T));
+
+		const uint8_t* tmp = reinterpret_cast<const uint8_t*>(&src);
+		for (size_t i = sizeof(T); i > 0; buffer[index++] = tmp[--i]);
+		return *this;
+	}
+
+	void write(const uint8_t* src, size_t len) {
+		while (len > 0) {
+			if (index == bufferSize)
+				overflow(len);
+
+			const size_t numBytes = std::min(len, bufferSize - index);
+			std::memcpy(&buffer[index], src, numBytes);
+			index += numBytes;
+			src += numBytes;
+			len -= numBytes;
+		}
+	}
+
+	size_t position() const {
+		return index;
+	}
+};
+
+template<>
+inline BEwriter& BEwriter::operator<<(const std::string& src) {
+	const size_t strLen = src.length();
+	if (strLen > UINT16_MAX)
+		throw std::length_error("[write_error] string length " + std::to_string(strLen) + " exceeds " + std::to_string(UINT16_MAX));
+
+	*this << static_cast<uint16_t>(strLen);
+	write(reinterpret_cast<const uint8_t*>(src.data()), strLen);
+
+	return *this;
+}
+
+
+// Writes into a heap buffer that doubles its capacity whenever it runs full.
+class BEbufferWriter : public BEwriter {
+protected:
+	void overflow(size_t required) override {
+		const size_t newSize = std::max(bufferSize * 2, index + required);
+		uint8_t* newBuffer = new uint8_t[newSize];
+		if (buffer) {
+			std::memcpy(newBuffer, buffer, index);
+			delete[] buffer;
+		}
+		buffer = newBuffer;
+		bufferSize = newSize;
+	}
+
+public:
+	BEbufferWriter(size_t initialSize = 16384) {
+		buffer = new uint8_t[initialSize];
+		bufferSize = initialSize;
+	}
+
+	~BEbufferWriter() {
+		delete[] buffer;
+	}
+
+	// hands the written bytes to the caller who has to delete[] them
+	uint8_t* release(size_t& size) {
+		uint8_t* data = buffer;
+		size = index;
+		buffer = nullptr;
+		bufferSize = 0;
+		index = 0;
+		return data;
+	}
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+#include <InternedString.hpp>
+
+// Process wide, thread safe table of dense block IDs. Blocks are registered once by name
+// (from the block lists at startup or when a palette holds an unknown block) and handled as
+// IDs in between, names are only needed when palettes are read or written.
+class BlockRegistry {
+public:
+	// never assigned, marks a missing block (and a textured triangle on the GPU)
+	static constexpr uint16_t none = UINT16_MAX;
+
+	// ID of the block, registered if it is not known yet
+	static uint16_t id(const InternedString& name);
+
+	// ID of the block or 'none' if it was never registered
+	static uint16_t find(const InternedString& name);
+
+	static InternedString name(uint16_t id);
+
+	// number of registered blocks, every ID is below it
+	static size_t size();
+
+	// registers every non empty line of the file in order
+	static void loadList(const std::string& filename);
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_FEATURES_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// compiles a single function for an extension, callers check CPUFeatures::get() before calling it
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+// Instruction set extensions of the executing cpu, detected once at runtime.
+namespace CPUFeatures {
+
+	struct Features {
+		bool avx2 = false;
+		bool avx512f = false;
+	};
+
+#ifdef CPU_FEATURES_X86
+	inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t registers[4]) {
+#ifdef _MSC_VER
+		int values[4];
+		__cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+		for (int i = 0; i < 4; i++)
+			registers[i] = static_cast<uint32_t>(values[i]);
+#else
+		__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+	}
+
+	inline uint64_t xgetbv() {
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32_t eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+	}
+#endif
+
+	inline Features detect() {
+		Features features;
+#ifdef CPU_FEATURES_X86
+		uint32_t registers[4];
+
+		cpuid(0, 0, registers);
+		const uint32_t maxLeaf = registers[0];
+		if (maxLeaf < 7)
+			return features;
+
+		// the os has to save the extended registers on context switches as well
+		cpuid(1, 0, registers);
+		const bool osxsave = (registers[2] >> 27) & 1;
+		if (!osxsave)
+			return features;
+
+		const uint64_t xcr0 = xgetbv();
+		const bool avxState = (xcr0 & 0x06) == 0x06;
+		const bool avx512State = (xcr0 & 0xE6) == 0xE6;
+
+		cpuid(7, 0, registers);
+		features.avx2 = avxState && ((registers[1] >> 5) & 1);
+		features.avx512f = avx512State && ((registers[1] >> 16) & 1);
+#endif
+		return features;
+	}
+
+	inline const Features& get() {
+		static const Features features = detect();
+		return features;
+	}
+}
@@ -20,18 +20,25 @@ struct Chunk {
 	size_t dataSize;
 	bool compressed;
 
+	// false as long as 'data' is what the region file holds, set by setNBT
+	bool modified;
+
 	chunkType type;
 
-	Chunk(chunkType _type) : type(_type), x(0), z(0), data(nullptr), dataSize(0), compressed(false) {};
+	Chunk(chunkType _type) : type(_type), x(0), z(0), data(nullptr), dataSize(0), compressed(false), modified(false) {};
 
-	Chunk(chunkType _type, int _x, int _z, uint8_t* _data, size_t _dataSize, bool _compressed) : type(_type), x(_x), z(_z), data(_data), dataSize(_dataSize), compressed(_compressed) {};
+	Chunk(chunkType _type, int _x, int _z, uint8_t* _data, size_t _dataSize, bool _compressed) : type(_type), x(_x), z(_z), data(_data), dataSize(_dataSize), compressed(_compressed), modified(false) {};
 
 	Chunk(const Chunk&);
 
 	Chunk(Chunk&&) noexcept;
 
 
-	static Chunk create(chunkType type, int x, int z);
+	// 1.16.5, used for chunks that are created where the world has none
+	static const int32_t defaultDataVersion = 2586;
+
+	// empty chunk in the layout of 'dataVersion'
+	static Chunk create(chunkType type, int x, int z, int32_t dataVersion = defaultDataVersion);
 
 
 	Chunk& operator=(const Chunk&);
@@ -44,7 +51,8 @@ struct Chunk {
 	void uncompress();
 
 	NBT getNBT();
-	void setNBT(const NBT& chunkData);
+	NBT getNBT(const std::vector<std::string>& paths, bool keepRest = false);
+	void setNBT(const NBT& chunkData, bool compress = false);
 
 	std::string toString();
 
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+
+#include <NBT.hpp>
+#include <InternedString.hpp>
+#include <SectionCodec.hpp>
+
+// Typed accessors for the parts of the Anvil chunk layout the modifiers use.
+// Keys are interned once at startup, so lookups only hash a pointer and never build strings.
+namespace ChunkSchema {
+
+	template<typename T>
+	struct Field {
+		const InternedString key;
+
+		Field(const char* name) : key{ name } {}
+
+		// nullptr if the compound has no such field or it holds another type
+		T* find(NBTcompound& compound) const {
+			auto it = compound.find(key);
+			return it == compound.end() ? nullptr : it->second.template try_get<T>();
+		}
+
+		T& get(NBTcompound& compound) const {
+			return static_cast<T&>(compound.at(key));
+		}
+
+		const T& get(const NBTcompound& compound) const {
+			return static_cast<const T&>(compound.at(key));
+		}
+
+		T& getOrInsert(NBTcompound& compound, T&& init = T{}) const {
+			auto it = compound.find(key);
+			if (it == compound.end())
+				it = compound.insert({ key, std::move(init) }).first;
+			return static_cast<T&>(it->second);
+		}
+
+		void set(NBTcompound& compound, T value) const {
+			compound[key] = std::move(value);
+		}
+	};
+
+	inline const Field<int32_t> DataVersion{ "DataVersion" };
+	inline const Field<NBTcompound> Level{ "Level" };
+	inline const Field<int32_t> xPos{ "xPos" };
+	inline const Field<int32_t> zPos{ "zPos" };
+	inline const Field<NBTlist> Sections{ "Sections" };
+	inline const Field<int8_t> Y{ "Y" };
+	inline const Field<NBTlist> Palette{ "Palette" };
+	inline const Field<NBTlongArray> BlockStates{ "BlockStates" };
+	inline const Field<NBTbyteArray> BlockLight{ "BlockLight" };
+	inline const Field<NBTstring> Name{ "Name" };
+
+	// since 21w43a
+	inline const Field<NBTlist> sections{ "sections" };
+	inline const Field<NBTcompound> block_states{ "block_states" };
+	inline const Field<NBTlist> palette{ "palette" };
+	inline const Field<NBTlongArray> data{ "data" };
+}
+
+
+// Sections of a chunk decoded once into typed references for the fields that get modified.
+// The references stay valid when sections are appended, as list elements keep their payloads on the heap.
+class ChunkSections {
+public:
+	// palette and block states are nullptr if the section has none
+	struct Section {
+		int8_t y;
+		NBTcompound* compound;
+		NBTlist* palette;
+		NBTlongArray* blockStates;
+	};
+
+private:
+	const SectionCodec& codec;
+	NBTcompound& level;
+	NBTlist& list;
+	std::vector<Section> sections;
+
+	// a single entry palette has no block states since 21w43a, they are inserted once something is written
+	NBTlongArray& blockStates(Section&) const;
+
+public:
+	ChunkSections(NBTcompound& root, const SectionCodec& codec);
+
+	const SectionCodec& getCodec() const {
+		return codec;
+	}
+
+	void setPosition(int32_t chunkX, int32_t chunkZ);
+
+	// nullptr if the chunk has no section at 'y'
+	Section* find(int8_t y);
+
+	// creates the section along with an empty palette and block states if they are missing
+	Section& getOrCreate(int8_t y);
+
+	// reads or writes the 4096 palette indices of a section in YZX order
+	void unpack(const Section&, uint16_t* indices) const;
+	void pack(Section&, const uint16_t* indices) const;
+
+	// reads or writes the palette indices at 'count' positions, the block states have to match the palette
+	void get(const Section&, const uint16_t* positions, size_t count, uint16_t* indices) const;
+	void set(Section&, const uint16_t* positions, const uint16_t* indices, size_t count) const;
+};
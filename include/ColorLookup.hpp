@@ -2,7 +2,10 @@
 
 #include <string>
 #include <vector>
+#include <thread>
+#include <algorithm>
 #include <color.h>
+#include <InternedString.hpp>
 
 template<typename T>
 class ColorLookup {
@@ -12,6 +15,56 @@ private:
 	std::vector<T> values;
 	size_t len = 0;
 
+	// Table of the colors quantized to 6 bits per color channel and 2 bits of alpha. Every cell lists the keys
+	// that can be the nearest one to some color inside of it, most cells list a single key, the others are searched exactly.
+	static constexpr uint32_t colorBits = 6, alphaBits = 2;
+	static constexpr size_t numCells = size_t(1) << (3 * colorBits + alphaBits);
+
+	std::vector<uint32_t> cells;		// first candidate of each cell, followed by the end of the last one
+	std::vector<uint16_t> candidates;	// key indices in ascending order, so ties resolve like the linear search
+
+	static size_t cellIndex(const color& key) {
+		return ((static_cast<size_t>(key.a >> (8 - alphaBits)) << colorBits | (key.r >> (8 - colorBits))) << colorBits |
+			(key.g >> (8 - colorBits))) << colorBits | (key.b >> (8 - colorBits));
+	}
+
+	static uint64_t delta(const color& a, const color& b) {
+		return static_cast<uint64_t>((a.r - b.r) * (a.r - b.r)) +
+			static_cast<uint64_t>((a.g - b.g) * (a.g - b.g)) +
+			static_cast<uint64_t>((a.b - b.b) * (a.b - b.b)) +
+			static_cast<uint64_t>((a.a - b.a) * (a.a - b.a));
+	}
+
+	// appends the keys of 'from' that are nearest to some color of the box spanning 'lower' to 'lower' + 'width'
+	// (channels r, g, b, a), the others are farther than the key nearest to the box's center everywhere in it
+	void prune(const int lower[4], const int width[4], const std::vector<int>& norms, const std::vector<uint16_t>& from, std::vector<uint16_t>& to) const {
+		const color center{
+			static_cast<uint8_t>(lower[0] + (width[0] + 1) / 2), static_cast<uint8_t>(lower[1] + (width[1] + 1) / 2),
+			static_cast<uint8_t>(lower[2] + (width[2] + 1) / 2), static_cast<uint8_t>(lower[3] + (width[3] + 1) / 2)
+		};
+
+		uint16_t best = from[0];
+		uint64_t bestDelta = UINT64_MAX;
+		for (const uint16_t i : from) {
+			const uint64_t keyDelta = delta(center, keys[i]);
+			if (keyDelta < bestDelta) {
+				bestDelta = keyDelta;
+				best = i;
+			}
+		}
+
+		// |x - key|^2 - |x - best|^2 is linear in x, so its minimum over the box lies in a corner
+		const color& bestKey = keys[best];
+		for (const uint16_t i : from) {
+			const int slope[4] = { 2 * (bestKey.r - keys[i].r), 2 * (bestKey.g - keys[i].g), 2 * (bestKey.b - keys[i].b), 2 * (bestKey.a - keys[i].a) };
+			int minDifference = norms[i] - norms[best];
+			for (int c = 0; c < 4; c++)
+				minDifference += slope[c] * lower[c] + std::min(0, slope[c] * width[c]);
+			if (minDifference <= 0)
+				to.push_back(i);
+		}
+	}
+
 public:
 	ColorLookup() : len{ 0 } {};
 
@@ -23,27 +76,127 @@ public:
 		keys.push_back(key);
 		values.push_back(value);
 		len++;
+		cells.clear();
 	}
 
 	void remove(size_t index) {
 		keys.erase(keys.begin() + index);
 		values.erase(values.begin() + index);
 		len--;
+		cells.clear();
+	}
+
+	// builds the quantized table that get uses from now on, inserting or removing keys drops it again
+	void buildTable(uint32_t numThreads) {
+		cells.clear();
+		candidates.clear();
+
+		if (len == 0 || len > UINT16_MAX)
+			return;
+
+		numThreads = std::max(numThreads, 1U);
+
+		std::vector<int> norms(len);
+		for (size_t i = 0; i < len; i++)
+			norms[i] = keys[i].r * keys[i].r + keys[i].g * keys[i].g + keys[i].b * keys[i].b + keys[i].a * keys[i].a;
+
+		std::vector<uint16_t> allKeys(len);
+		for (size_t i = 0; i < len; i++)
+			allKeys[i] = static_cast<uint16_t>(i);
+
+		//------------------------/ candidates per slab /------------------------//
+
+		// a slab holds the cells of one alpha and red interval, each is filled by one thread
+		const size_t cellsPerSlab = size_t(1) << (2 * colorBits);
+		const size_t numSlabs = numCells / cellsPerSlab;
+
+		cells.resize(numCells + 1);
+		std::vector<std::vector<uint16_t>> slabCandidates(numSlabs);
+
+		const size_t slabsPerThread = (numSlabs + numThreads - 1) / numThreads;
+		std::vector<std::thread> threads;
+		for (size_t begin = 0; begin < numSlabs; begin += slabsPerThread) {
+			threads.emplace_back([&, begin]() {
+				const int colorWidth = 1 << (8 - colorBits), alphaWidth = 1 << (8 - alphaBits);
+				const size_t end = std::min(begin + slabsPerThread, numSlabs);
+
+				// the cells are only checked against the candidates of their group of 4x4 green and blue cells
+				const int groupCells = 4, groupsPerAxis = (1 << colorBits) / groupCells;
+				std::vector<std::vector<uint16_t>> groups(static_cast<size_t>(groupsPerAxis * groupsPerAxis));
+
+				for (size_t slab = begin; slab < end; slab++) {
+					std::vector<uint16_t>& local = slabCandidates[slab];
+
+					const int red = static_cast<int>(slab & ((1 << colorBits) - 1)) * colorWidth;
+					const int alpha = static_cast<int>(slab >> colorBits) * alphaWidth;
+
+					for (int group = 0; group < groupsPerAxis * groupsPerAxis; group++) {
+						const int lower[4] = { red, (group / groupsPerAxis) * groupCells * colorWidth, (group % groupsPerAxis) * groupCells * colorWidth, alpha };
+						const int width[4] = { colorWidth - 1, groupCells * colorWidth - 1, groupCells * colorWidth - 1, alphaWidth - 1 };
+						groups[group].clear();
+						prune(lower, width, norms, allKeys, groups[group]);
+					}
+
+					for (size_t cell = 0; cell < cellsPerSlab; cell++) {
+						const int green = static_cast<int>(cell >> colorBits), blue = static_cast<int>(cell & ((1 << colorBits) - 1));
+
+						const int lower[4] = { red, green * colorWidth, blue * colorWidth, alpha };
+						const int width[4] = { colorWidth - 1, colorWidth - 1, colorWidth - 1, alphaWidth - 1 };
+
+						cells[slab * cellsPerSlab + cell] = static_cast<uint32_t>(local.size());
+						prune(lower, width, norms, groups[(green / groupCells) * groupsPerAxis + blue / groupCells], local);
+					}
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+
+		//------------------------/ merge slabs /------------------------//
+
+		size_t numCandidates = 0;
+		for (const std::vector<uint16_t>& local : slabCandidates)
+			numCandidates += local.size();
+		candidates.reserve(numCandidates);
+
+		for (size_t slab = 0; slab < numSlabs; slab++) {
+			const uint32_t offset = static_cast<uint32_t>(candidates.size());
+			for (size_t cell = slab * cellsPerSlab; cell < (slab + 1) * cellsPerSlab; cell++)
+				cells[cell] += offset;
+			candidates.insert(candidates.end(), slabCandidates[slab].begin(), slabCandidates[slab].end());
+		}
+		cells[numCells] = static_cast<uint32_t>(candidates.size());
 	}
 
 	T get(const color& key) const {
+		if (!cells.empty()) {
+			const size_t cell = cellIndex(key);
+			const uint32_t first = cells[cell], last = cells[cell + 1];
+
+			if (last - first == 1)
+				return values[candidates[first]];
+
+			uint64_t minDelta = UINT64_MAX;
+			size_t index = 0;
+			for (uint32_t i = first; i < last; i++) {
+				const uint64_t candidateDelta = delta(key, keys[candidates[i]]);
+				if (candidateDelta < minDelta) {
+					minDelta = candidateDelta;
+					index = candidates[i];
+				}
+			}
+			return values[index];
+		}
+
 		uint64_t minDelta = UINT64_MAX;
 		size_t index = 0;
 		for (size_t i = 0; i < len; i++) {
-			uint64_t delta = static_cast<uint64_t>((key.r - keys[i].r) * (key.r - keys[i].r)) +
-				static_cast<uint64_t>((key.g - keys[i].g) * (key.g - keys[i].g)) +
-				static_cast<uint64_t>((key.b - keys[i].b) * (key.b - keys[i].b)) +
-				static_cast<uint64_t>((key.a - keys[i].a) * (key.a - keys[i].a));
+			uint64_t keyDelta = delta(key, keys[i]);
 
-			if (delta < minDelta) {
-				minDelta = delta;
+			if (keyDelta < minDelta) {
+				minDelta = keyDelta;
 				index = i;
-				if (delta == 0)
+				if (keyDelta == 0)
 					break;
 			}
 		}
@@ -76,6 +229,15 @@ inline std::string ColorLookup<std::string>::toString() const {
 	return out;
 }
 
+template<>
+inline std::string ColorLookup<InternedString>::toString() const {
+	std::string out;
+	for (size_t i = 0; i < len; i++) {
+		out += keys[i].toString() + " " + values[i].string() + "\n";
+	}
+	return out;
+}
+
 template<>
 inline std::string ColorLookup<std::uint16_t>::toString() const {
 	std::string out;
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <functional>
+
+// Handle to a string in a process wide, thread safe pool. Equal strings share a single
+// copy that lives until the program exits, so comparing and hashing only touch the pointer.
+class InternedString {
+private:
+	const std::string* str;
+
+	static const std::string* intern(std::string_view);
+
+public:
+	InternedString() : str(intern({})) {}
+	InternedString(std::string_view s) : str(intern(s)) {}
+	InternedString(const std::string& s) : str(intern(s)) {}
+	InternedString(const char* s) : str(intern(s)) {}
+
+	const std::string& string() const {
+		return *str;
+	}
+
+	operator const std::string& () const {
+		return *str;
+	}
+
+	size_t length() const {
+		return str->length();
+	}
+
+	bool empty() const {
+		return str->empty();
+	}
+
+	bool operator==(const InternedString& other) const {
+		return str == other.str;
+	}
+
+	bool operator!=(const InternedString& other) const {
+		return str != other.str;
+	}
+
+	friend struct std::hash<InternedString>;
+};
+
+namespace std {
+	template<>
+	struct hash<InternedString> {
+		size_t operator()(const InternedString& s) const noexcept {
+			return hash<const std::string*>()(s.str);
+		}
+	};
+}
@@ -2,38 +2,28 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <variant>
 #include <unordered_map>
 #include <sstream>
 #include <stdexcept>
 #include <functional>
+#include <typeinfo>
 
-#include <BEstream.hpp>
+#include <BEreader.hpp>
+#include <BEwriter.hpp>
+#include <InternedString.hpp>
 
 
 class NBT;
+struct NBTfilter;
 
 using NBTstring = std::string;
 using NBTbyteArray = std::vector<int8_t>;
 using NBTintArray = std::vector<int32_t>;
 using NBTlongArray = std::vector<int64_t>;
 using NBTlist = std::vector<NBT>;
-using NBTcompound = std::unordered_map<std::string, NBT>;
-
-union NBTtag {
-	bool Boolean;
-	int8_t Byte;
-	int16_t Short;
-	int32_t Int;
-	int64_t Long;
-	float Float;
-	double Double;
-	NBTstring* String;
-	NBTbyteArray* ByteArray;
-	NBTintArray* IntArray;
-	NBTlongArray* LongArray;
-	NBTlist* List;
-	NBTcompound* Compound;
-};
+using NBTcompound = std::unordered_map<InternedString, NBT>;
 
 enum class NBTtagType : uint8_t {
 	end = 0,
@@ -50,35 +40,103 @@ enum class NBTtagType : uint8_t {
 	IntArray = 11,
 	LongArray = 12,
 	Boolean = 13,
+	raw = UINT8_MAX - 1,
 	null = UINT8_MAX
 };
 
+// verbatim copy of an encoded tag payload that has not been parsed (yet)
+struct NBTraw {
+	NBTtagType type;
+	std::vector<uint8_t> payload;
+};
+
+// Keeps a compound on the heap, so references into it survive moves of the owning tag
+// (e.g. when the list holding it grows). Copies are deep.
+class NBTcompoundBox {
+private:
+	std::unique_ptr<NBTcompound> compound;
+
+public:
+	NBTcompoundBox();
+	NBTcompoundBox(const NBTcompound&);
+	NBTcompoundBox(NBTcompound&&);
+	NBTcompoundBox(const NBTcompoundBox&);
+	NBTcompoundBox(NBTcompoundBox&&) noexcept = default;
+	~NBTcompoundBox();
+
+	NBTcompoundBox& operator=(const NBTcompoundBox&);
+	NBTcompoundBox& operator=(NBTcompoundBox&&) noexcept;
+
+	NBTcompound* get() const {
+		return compound.get();
+	}
+};
+
+// Alternatives are ordered like NBTtagType, so the index of the held alternative is its tag id.
+// Scalars, strings and arrays are stored inline, std::monostate is the null tag.
+using NBTvalue = std::variant<
+	std::monostate,
+	int8_t,
+	int16_t,
+	int32_t,
+	int64_t,
+	float,
+	double,
+	NBTbyteArray,
+	NBTstring,
+	NBTlist,
+	NBTcompoundBox,
+	NBTintArray,
+	NBTlongArray,
+	bool,
+	NBTraw
+>;
+
 class NBT {
 private:
-	NBTtag data;
-	NBTtagType type;
+	// raw payloads are decoded lazily on first access, which does not change the logical value
+	mutable NBTvalue value;
+
+	void decodeRaw() const;
 
-	void cleanup();
+	NBTtagType encodedType() const;
+
+	template<typename T>
+	T& as() const;
+
+	template<typename T>
+	T number() const;
+
+	template<typename T>
+	NBT& assignNumber(T);
+
+	template<typename T>
+	NBT& assignValue(T&&);
 
 	static const constexpr char tab = '\t';
 
 	static const auto getParser(NBTtagType);
 
-	static NBT parseBool(BEstream&);
-	static NBT parseByte(BEstream&);
-	static NBT parseShort(BEstream&);
-	static NBT parseInt(BEstream&);
-	static NBT parseLong(BEstream&);
-	static NBT parseString(BEstream&);
-	static NBT parseByteArray(BEstream&);
-	static NBT parseIntArray(BEstream&);
-	static NBT parseLongArray(BEstream&);
-	static NBT parseList(BEstream&);
-	static NBT parseCompound(BEstream&);
+	static NBT parseBool(BEreader&);
+	static NBT parseByte(BEreader&);
+	static NBT parseShort(BEreader&);
+	static NBT parseInt(BEreader&);
+	static NBT parseLong(BEreader&);
+	static NBT parseFloat(BEreader&);
+	static NBT parseDouble(BEreader&);
+	static NBT parseString(BEreader&);
+	static NBT parseByteArray(BEreader&);
+	static NBT parseIntArray(BEreader&);
+	static NBT parseLongArray(BEreader&);
+	static NBT parseList(BEreader&);
+	static NBT parseCompound(BEreader&);
+
+	static NBT parseFiltered(BEreader&, NBTtagType, const NBTfilter&, size_t& pending, bool keepRest);
+	static NBT parseFilteredCompound(BEreader&, const NBTfilter&, size_t& pending, bool keepRest);
 
-	void serialize(BEstream&) const;
+	static void skip(BEreader&, NBTtagType, std::vector<uint8_t>* capture = nullptr);
 
-	size_t size(bool firstCall = true) const;
+	void serializePayload(BEwriter&) const;
 
 public:
 
@@ -107,19 +165,52 @@ public:
 	NBT(NBTlist&&);
 	NBT(NBTcompound&&);
 
+	NBT(NBTraw&&);
+
 	~NBT();
 
 	static std::string typeToString(NBTtagType);
 
 	static NBT parse(uint8_t* buffer, size_t size);
 
+	static NBT parse(BEreader& is);
+
+	// only parses the dot separated 'paths' (e.g. "Level.Sections") and stops reading
+	// as soon as all of them have been found. With 'keepRest' everything else is kept as raw
+	// payload that is decoded on first access and otherwise written back verbatim.
+	static NBT parse(BEreader& is, const std::vector<std::string>& paths, bool keepRest = false);
+
 	size_t length();
 
 	uint8_t* serialize(size_t& size) const;
 
+	void serialize(BEwriter& os) const;
+
 	void toString(std::stringstream& out, int indent = -1) const;
 
-	NBTtagType getType() const { return type; };
+	NBTtagType getType() const {
+		switch (value.index()) {
+		case 0:		return NBTtagType::null;
+		case std::variant_size_v<NBTvalue> - 1:	return NBTtagType::raw;
+		default:	return static_cast<NBTtagType>(value.index());
+		}
+	}
+
+	void decode() const {
+		if (std::holds_alternative<NBTraw>(value))
+			decodeRaw();
+	}
+
+	// nullptr instead of std::bad_cast if the tag holds another type
+	template<typename T>
+	T* try_get();
+
+	template<typename T>
+	const T* try_get() const;
+
+	// nullptr if the tag is no compound or has no element 'key'
+	NBT* find(const InternedString& key);
+	const NBT* find(const InternedString& key) const;
 
 
 	explicit operator bool() const;
@@ -177,62 +268,74 @@ public:
 	NBT& operator=(NBTcompound&&);
 
 	NBT& operator[](const size_t);
-	NBT& operator[](const std::string&);
+	NBT& operator[](const InternedString&);
 
 	template<typename T>
 	T& at(const size_t index) {
-		if (type == NBTtagType::List) {
-			return static_cast<T&>(data.List->at(index));
+		if (NBTlist* list = try_get<NBTlist>()) {
+			return static_cast<T&>(list->at(index));
 		}
 		throw std::bad_cast();
 	}
 
 	template<typename T>
-	T& at(const std::string& key) {
-		if (type == NBTtagType::Compound) {
-			return static_cast<T&>(data.Compound->at(key));
+	T& at(const InternedString& key) {
+		if (NBTcompound* compound = try_get<NBTcompound>()) {
+			return static_cast<T&>(compound->at(key));
 		}
 		throw std::bad_cast();
 	}
 
 	template<typename T>
 	const T& get(const size_t index) const {
-		if (type == NBTtagType::List) {
-			return static_cast<T&>(data.List->at(index));
-		}
-		throw std::bad_cast();
+		return const_cast<NBT*>(this)->at<T>(index);
 	}
 
 	template<typename T>
-	const T& get(const std::string& key) const {
-		if (type == NBTtagType::Compound) {
-			return static_cast<T&>(data.Compound->at(key));
-		}
-		throw std::bad_cast();
+	const T& get(const InternedString& key) const {
+		return const_cast<NBT*>(this)->at<T>(key);
 	}
 };
 
 
+
+template<typename T>
+T* NBT::try_get() {
+	decode();
+	if constexpr (std::is_same_v<T, NBTcompound>) {
+		NBTcompoundBox* box = std::get_if<NBTcompoundBox>(&value);
+		return box ? box->get() : nullptr;
+	} else {
+		return std::get_if<T>(&value);
+	}
+}
+
+template<typename T>
+const T* NBT::try_get() const {
+	return const_cast<NBT*>(this)->try_get<T>();
+}
+
+
 template<>
 inline int8_t& NBT::at(const size_t index) {
-	if (type == NBTtagType::ByteArray) {
-		return (*data.ByteArray)[index];
+	if (NBTbyteArray* array = try_get<NBTbyteArray>()) {
+		return (*array)[index];
 	}
 	throw std::bad_cast();
 }
 
 template<>
 inline int32_t& NBT::at(const size_t index) {
-	if (type == NBTtagType::IntArray) {
-		return (*data.IntArray)[index];
+	if (NBTintArray* array = try_get<NBTintArray>()) {
+		return (*array)[index];
 	}
 	throw std::bad_cast();
 }
 
 template<>
 inline int64_t& NBT::at(const size_t index) {
-	if (type == NBTtagType::LongArray) {
-		return (*data.LongArray)[index];
+	if (NBTlongArray* array = try_get<NBTlongArray>()) {
+		return (*array)[index];
 	}
 	throw std::bad_cast();
 }
@@ -240,24 +343,15 @@ inline int64_t& NBT::at(const size_t index) {
 
 template<>
 inline const int8_t& NBT::get(const size_t index) const {
-	if (type == NBTtagType::ByteArray) {
-		return (*data.ByteArray)[index];
-	}
-	throw std::bad_cast();
+	return const_cast<NBT*>(this)->at<int8_t>(index);
 }
 
 template<>
 inline const int32_t& NBT::get(const size_t index) const {
-	if (type == NBTtagType::IntArray) {
-		return (*data.IntArray)[index];
-	}
-	throw std::bad_cast();
+	return const_cast<NBT*>(this)->at<int32_t>(index);
 }
 
 template<>
 inline const int64_t& NBT::get(const size_t index) const {
-	if (type == NBTtagType::LongArray) {
-		return (*data.LongArray)[index];
-	}
-	throw std::bad_cast();
+	return const_cast<NBT*>(this)->at<int64_t>(index);
 }
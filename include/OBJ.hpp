@@ -9,11 +9,12 @@
 #include <vd2.hpp>
 #include <Image.hpp>
 #include <cStructs.h>
+#include <BlockRegistry.hpp>
 
 struct material {
 	std::string name;
 	color c { 0, 0, 0, 255 };
-	std::string blockID;
+	uint16_t blockID { BlockRegistry::none };
 	size_t texIndex { SIZE_MAX };
 };
 
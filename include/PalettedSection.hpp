@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include <ChunkSchema.hpp>
+
+// The blocks a model writes to one section, each position at most once.
+struct SectionPatch {
+	std::vector<uint16_t> positions;	// x + z * 16 + y * 256
+	std::vector<uint16_t> blockIDs;
+
+	void push(uint16_t position, uint16_t blockID) {
+		positions.push_back(position);
+		blockIDs.push_back(blockID);
+	}
+
+	size_t size() const {
+		return positions.size();
+	}
+
+	bool empty() const {
+		return positions.empty();
+	}
+};
+
+
+// The palette indices of a section together with its palette, in the style of the game's PalettedContainer.
+// Counts how many blocks use each palette entry, so entries that were overwritten are dropped on encode
+// and the block states are written with the smallest width the remaining palette needs.
+class PalettedSection {
+private:
+	const ChunkSections& sections;
+	ChunkSections::Section section;
+
+	uint16_t indices[4096];
+	std::vector<uint32_t> refCounts;	// per palette slot
+	std::vector<uint16_t> blockIDs;		// BlockRegistry ID per palette slot
+	std::vector<uint16_t> slots;		// first palette slot per block ID, UINT16_MAX if there is none
+
+	void index();
+
+	bool hasUnusedSlots() const {
+		return std::find(refCounts.begin(), refCounts.end(), 0) != refCounts.end();
+	}
+
+public:
+	// decodes the section, an empty palette gets 'emptyBlock' so the zeroed indices of a new section are valid
+	PalettedSection(const ChunkSections&, const ChunkSections::Section&, uint16_t emptyBlock);
+
+	size_t paletteSize() const {
+		return blockIDs.size();
+	}
+
+	uint16_t slot(size_t index) const {
+		return indices[index];
+	}
+
+	uint16_t blockID(size_t index) const {
+		return blockIDs[indices[index]];
+	}
+
+	// palette slot of the block, appended to the palette if it has none
+	uint16_t slotOf(uint16_t blockID);
+
+	void set(size_t index, uint16_t slot) {
+		refCounts[indices[index]]--;
+		refCounts[slot]++;
+		indices[index] = slot;
+	}
+
+	// a block that already holds 'blockID' keeps its slot, and with it its properties, false if nothing changed
+	bool setBlock(size_t index, uint16_t blockID) {
+		if (blockIDs[indices[index]] == blockID)
+			return false;
+		set(index, slotOf(blockID));
+		return true;
+	}
+
+	// drops unused palette entries and writes the palette and the block states back to the section
+	void encode();
+
+	// writes the patch to section 'y', false if it holds the patched blocks already and was left untouched.
+	// If the palette keeps its entries, only the changed blocks are written to the packed block states,
+	// a patch that adds a block or drops the last use of one re-encodes the section with a compacted palette.
+	static bool apply(ChunkSections& sections, int8_t y, const SectionPatch& patch, uint16_t emptyBlock);
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <vf3.hpp>
+#include <vd3.hpp>
+#include <OBJ.hpp>
+
+// Everything the voxelizer needs from a triangle that does not depend on the voxel, computed once per model.
+// The separating axis tests are stored as intervals, so testing a voxel only projects its center.
+// Positions are relative to 'anchor', the voxel of the first vertex, which keeps the floats small in large worlds.
+struct PreparedTriangle {
+	// the voxel centered at c is separated if a * c[i] - b * c[j] leaves [lower, upper], with
+	// i = (k + 1) % 3 and j = (k + 2) % 3 for the cross product of an edge with axis k
+	struct Axis {
+		float a, b;
+		float lower, upper;
+		float brickLower, brickUpper;
+	};
+
+	int anchor[3];
+
+	vf3 vertices[3];
+	vf3 edges[3];		// v1 - v0, v2 - v1, v0 - v2
+	vf3 normal;			// edges[0] x edges[1]
+	float planeOffset;	// normal . v0
+	vf3 min, max;
+
+	// closed range of voxels the bounds touch, voxel i covers [i, i + 1] (world coordinates)
+	int voxelMin[3], voxelMax[3];
+
+	Axis edgeAxes[9];	// edge * 3 + k
+	vf3 extentLower, extentUpper;
+	float planeLower, planeUpper;
+
+	// the same intervals for 4x4x4 bricks, widened a little so the brick test never rejects a voxel hit
+	vf3 brickExtentLower, brickExtentUpper;
+	float brickPlaneLower, brickPlaneUpper;
+
+	// affine texture mapping of p (relative to the anchor): u = uGradient . p + uOffset, v = vGradient . p + vOffset
+	vf3 uGradient, vGradient;
+	float uOffset, vOffset;
+
+	material const* m;
+
+	PreparedTriangle() = default;
+
+	PreparedTriangle(const pointerTriangle&);
+
+	// center of the voxel at the world position x, y, z relative to the anchor
+	vf3 voxelCenter(int x, int y, int z) const {
+		return vf3(
+			static_cast<float>(x - anchor[0]) + 0.5f,
+			static_cast<float>(y - anchor[1]) + 0.5f,
+			static_cast<float>(z - anchor[2]) + 0.5f
+		);
+	}
+
+	// separating axis test against the unit voxel at 'center' (relative to the anchor)
+	bool overlapsVoxel(const vf3& center) const;
+
+	// conservative test against the 4x4x4 brick at 'center' (relative to the anchor)
+	bool overlapsBrick(const vf3& center) const;
+
+	// texture coordinates of the point 'p' (relative to the anchor) in the plane of the triangle
+	void texCoord(const vf3& p, float& u, float& v) const {
+		u = uGradient.x * p.x + uGradient.y * p.y + uGradient.z * p.z + uOffset;
+		v = vGradient.x * p.x + vGradient.y * p.y + vGradient.z * p.z + vOffset;
+	}
+
+	bool textured() const {
+		return m && m->texIndex != SIZE_MAX;
+	}
+
+	static std::vector<PreparedTriangle> prepare(const std::vector<pointerTriangle>&, uint32_t numThreads);
+};
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <stdexcept>
+#include <algorithm>
 
 #include <Chunk.hpp>
 #include <vf3.hpp>
@@ -16,8 +17,14 @@ struct Region {
 
 	static Region loadMCA(const std::string &filename, int x, int z);
 
+	// missing chunks that intersect the object are created in the layout of 'dataVersion'
 	static void loadMCAtoBuffer(const std::string& filename, int x, int z, const vf3& min, const vf3& max,
-		LockableQueue<Chunk>& inputBuffer, LockableQueue<Chunk>& outputBuffer);
+		LockableQueue<Chunk>& inputBuffer, LockableQueue<Chunk>& outputBuffer, int32_t dataVersion = Chunk::defaultDataVersion);
 
 	void saveMCA(const std::string &path);
+
+	// false if every chunk still holds the data of the region file
+	bool modified() const {
+		return std::any_of(chunks.begin(), chunks.end(), [](const Chunk& chunk) { return chunk.modified; });
+	}
 };
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+
+#include <NBT.hpp>
+
+
+// How block state palette indices are packed into longs.
+enum class BlockStatesPacking : uint8_t {
+	Spanning,	// before 20w17a (DataVersion 2529) entries continue in the next long
+	Padded		// since 20w17a entries never span two longs, the remaining high bits stay unused
+};
+
+// Where the sections and their block data are stored.
+enum class ChunkLayout : uint8_t {
+	Level,		// "Level.Sections[].Palette" and "BlockStates", sections 0 to 15
+	Flattened	// since 21w43a (DataVersion 2844) "sections[].block_states.palette" and "data", sections -4 to 19
+};
+
+// Calls 'function' with the bit width as std::integral_constant for the common widths 4 to 12,
+// so the shifts, masks and divisions of the codec fold into constants, and as uint32_t otherwise.
+template<typename Function>
+inline void withBitsPerBlock(uint32_t bitsPerBlock, Function&& function) {
+	switch (bitsPerBlock) {
+	case 4: function(std::integral_constant<uint32_t, 4>{}); break;
+	case 5: function(std::integral_constant<uint32_t, 5>{}); break;
+	case 6: function(std::integral_constant<uint32_t, 6>{}); break;
+	case 7: function(std::integral_constant<uint32_t, 7>{}); break;
+	case 8: function(std::integral_constant<uint32_t, 8>{}); break;
+	case 9: function(std::integral_constant<uint32_t, 9>{}); break;
+	case 10: function(std::integral_constant<uint32_t, 10>{}); break;
+	case 11: function(std::integral_constant<uint32_t, 11>{}); break;
+	case 12: function(std::integral_constant<uint32_t, 12>{}); break;
+	default: function(bitsPerBlock); break;
+	}
+}
+
+// 'Bits' is uint32_t or a std::integral_constant of it (see withBitsPerBlock).
+template<BlockStatesPacking>
+struct BlockStatesCodec;
+
+template<>
+struct BlockStatesCodec<BlockStatesPacking::Spanning> {
+	static size_t numLongs(uint32_t bitsPerBlock) {
+		return (4096ULL * bitsPerBlock + 63ULL) / 64ULL;
+	}
+
+	template<typename Bits>
+	static void unpack(const int64_t* longs, Bits bitsPerBlock, uint16_t* indices) {
+		const uint64_t mask = (1ULL << bitsPerBlock) - 1ULL;
+		for (size_t i = 0, bit = 0; i < 4096; i++, bit += bitsPerBlock) {
+			const size_t index = bit / 64, offset = bit % 64;
+			uint64_t value = static_cast<uint64_t>(longs[index]) >> offset;
+			if (offset + bitsPerBlock > 64)
+				value |= static_cast<uint64_t>(longs[index + 1]) << (64 - offset);
+			indices[i] = static_cast<uint16_t>(value & mask);
+		}
+	}
+
+	static uint16_t get(const int64_t* longs, uint32_t bitsPerBlock, size_t i) {
+		const size_t bit = i * bitsPerBlock, index = bit / 64, offset = bit % 64;
+		uint64_t value = static_cast<uint64_t>(longs[index]) >> offset;
+		if (offset + bitsPerBlock > 64)
+			value |= static_cast<uint64_t>(longs[index + 1]) << (64 - offset);
+		return static_cast<uint16_t>(value & ((1ULL << bitsPerBlock) - 1ULL));
+	}
+
+	static void set(int64_t* longs, uint32_t bitsPerBlock, size_t i, uint16_t value) {
+		const uint64_t mask = (1ULL << bitsPerBlock) - 1ULL;
+		const size_t bit = i * bitsPerBlock, index = bit / 64, offset = bit % 64;
+		longs[index] = static_cast<int64_t>((static_cast<uint64_t>(longs[index]) & ~(mask << offset)) | (static_cast<uint64_t>(value) << offset));
+		if (offset + bitsPerBlock > 64)
+			longs[index + 1] = static_cast<int64_t>((static_cast<uint64_t>(longs[index + 1]) & ~(mask >> (64 - offset))) | (static_cast<uint64_t>(value) >> (64 - offset)));
+	}
+
+	template<typename Bits>
+	static void pack(const uint16_t* indices, Bits bitsPerBlock, int64_t* longs) {
+		std::fill(longs, longs + numLongs(bitsPerBlock), 0);
+		for (size_t i = 0, bit = 0; i < 4096; i++, bit += bitsPerBlock) {
+			const size_t index = bit / 64, offset = bit % 64;
+			const uint64_t value = indices[i];
+			longs[index] |= static_cast<int64_t>(value << offset);
+			if (offset + bitsPerBlock > 64)
+				longs[index + 1] |= static_cast<int64_t>(value >> (64 - offset));
+		}
+	}
+};
+
+template<>
+struct BlockStatesCodec<BlockStatesPacking::Padded> {
+	static size_t numLongs(uint32_t bitsPerBlock) {
+		const size_t blocksPerLong = 64 / bitsPerBlock;
+		return (4096 + blocksPerLong - 1) / blocksPerLong;
+	}
+
+	// walks long by long, so there is no division per entry even for runtime widths
+	template<typename Bits>
+	static void unpack(const int64_t* longs, Bits bitsPerBlock, uint16_t* indices, size_t firstLong = 0) {
+		const uint64_t mask = (1ULL << bitsPerBlock) - 1ULL;
+		const size_t blocksPerLong = 64 / bitsPerBlock;
+		for (size_t l = firstLong, i = firstLong * blocksPerLong; i < 4096; l++) {
+			uint64_t value = static_cast<uint64_t>(longs[l]);
+			for (size_t j = 0; j < blocksPerLong && i < 4096; j++, i++, value >>= bitsPerBlock)
+				indices[i] = static_cast<uint16_t>(value & mask);
+		}
+	}
+
+	template<typename Bits>
+	static void pack(const uint16_t* indices, Bits bitsPerBlock, int64_t* longs, size_t firstLong = 0) {
+		const size_t blocksPerLong = 64 / bitsPerBlock;
+		for (size_t l = firstLong, i = firstLong * blocksPerLong; i < 4096; l++) {
+			uint64_t value = 0;
+			for (size_t j = 0; j < blocksPerLong && i < 4096; j++, i++)
+				value |= static_cast<uint64_t>(indices[i]) << (j * bitsPerBlock);
+			longs[l] = static_cast<int64_t>(value);
+		}
+	}
+
+	static uint16_t get(const int64_t* longs, uint32_t bitsPerBlock, size_t i) {
+		const size_t blocksPerLong = 64 / bitsPerBlock;
+		const size_t offset = (i % blocksPerLong) * bitsPerBlock;
+		return static_cast<uint16_t>((static_cast<uint64_t>(longs[i / blocksPerLong]) >> offset) & ((1ULL << bitsPerBlock) - 1ULL));
+	}
+
+	static void set(int64_t* longs, uint32_t bitsPerBlock, size_t i, uint16_t value) {
+		const uint64_t mask = (1ULL << bitsPerBlock) - 1ULL;
+		const size_t blocksPerLong = 64 / bitsPerBlock;
+		const size_t offset = (i % blocksPerLong) * bitsPerBlock;
+		int64_t& word = longs[i / blocksPerLong];
+		word = static_cast<int64_t>((static_cast<uint64_t>(word) & ~(mask << offset)) | (static_cast<uint64_t>(value) << offset));
+	}
+
+	// AVX2 versions for the widths 4 to 12, false (and nothing done) if the cpu or width is not supported
+	static bool unpackAVX2(const int64_t* longs, uint32_t bitsPerBlock, uint16_t* indices);
+	static bool packAVX2(const uint16_t* indices, uint32_t bitsPerBlock, int64_t* longs);
+};
+
+
+// Reads and writes section block data in the native format of a chunk's DataVersion,
+// so worlds don't have to be upgraded by the game before they can be modified.
+class SectionCodec {
+public:
+	const int8_t minSectionY, maxSectionY;
+
+	SectionCodec(int8_t _minSectionY, int8_t _maxSectionY) : minSectionY{ _minSectionY }, maxSectionY{ _maxSectionY } {}
+
+	virtual ~SectionCodec() = default;
+
+	// compound that holds the chunk position and the section list
+	virtual NBTcompound& level(NBTcompound& root) const = 0;
+	virtual NBTlist& sections(NBTcompound& level) const = 0;
+
+	// nullptr if the section has no block data (e.g. light only)
+	virtual NBTlist* findPalette(NBTcompound& section) const = 0;
+	virtual NBTlongArray* findBlockStates(NBTcompound& section) const = 0;
+
+	virtual NBTlist& getOrInsertPalette(NBTcompound& section) const = 0;
+	virtual NBTlongArray& getOrInsertBlockStates(NBTcompound& section) const = 0;
+
+	virtual uint32_t bitsPerBlock(size_t paletteSize) const = 0;
+	virtual size_t numLongs(size_t paletteSize) const = 0;
+
+	// 'indices' holds 4096 palette indices in YZX order
+	virtual void unpack(const NBTlongArray& blockStates, size_t paletteSize, uint16_t* indices) const = 0;
+	virtual void pack(const uint16_t* indices, size_t paletteSize, NBTlongArray& blockStates) const = 0;
+
+	// reads or writes only the palette indices at 'count' positions, without touching the other entries
+	virtual void get(const NBTlongArray& blockStates, size_t paletteSize, const uint16_t* positions, size_t count, uint16_t* indices) const = 0;
+	virtual void set(NBTlongArray& blockStates, size_t paletteSize, const uint16_t* positions, const uint16_t* indices, size_t count) const = 0;
+
+	// nullptr for versions that predate block palettes
+	static const SectionCodec* forDataVersion(int32_t dataVersion);
+};
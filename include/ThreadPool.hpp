@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <exception>
+
+// Fixed set of worker threads that run parallel loops. Loops may be started from several
+// threads at once, the calling thread works on its own loop until every index is done.
+class ThreadPool {
+private:
+	struct Loop {
+		std::function<void(size_t)> function;
+		size_t count;
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> finished{ 0 };
+
+		std::mutex mtx;
+		std::condition_variable done;
+		std::exception_ptr error;
+	};
+
+	std::vector<std::thread> threads;
+
+	std::mutex mtx;
+	std::condition_variable wakeup;
+	std::deque<std::shared_ptr<Loop>> loops;
+	bool stopping = false;
+
+	void work();
+	static void run(Loop&);
+
+public:
+	explicit ThreadPool(uint32_t numThreads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// calls 'function' for every index in [0, count) and rethrows the first exception
+	void parallelFor(size_t count, const std::function<void(size_t)>& function);
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <utility>
+
+#include <vf3.hpp>
+#include <mcBoundingBox.hpp>
+
+// Triangle indices binned into the 16x16x16 sections of the working volume, stored as one
+// compressed row per section (CSR). A triangle is listed in every section its bounds touch,
+// each list is sorted in model order.
+class TriangleBins {
+public:
+	struct Range {
+		const uint32_t* first;
+		const uint32_t* last;
+
+		const uint32_t* begin() const { return first; }
+		const uint32_t* end() const { return last; }
+		size_t size() const { return static_cast<size_t>(last - first); }
+		bool empty() const { return first == last; }
+	};
+
+	// writes the bounds of triangle 'index' to 'min' and 'max'
+	using BoundsFunction = std::function<void(uint32_t index, vf3& min, vf3& max)>;
+
+private:
+	int minChunkX, minChunkZ, minSectionY;
+	int numChunksX, numChunksZ, numSectionsY;
+
+	std::vector<uint32_t> offsets;		// numCells + 1 entries
+	std::vector<uint32_t> indices;
+
+	// -1 if outside of the grid
+	int64_t cellIndex(int chunkX, int chunkZ, int sectionY) const;
+
+public:
+	TriangleBins(const mcBoundingBox& workingVolume, uint32_t numTriangles, const BoundsFunction& bounds, uint32_t numThreads);
+
+	Range section(int chunkX, int chunkZ, int sectionY) const;
+
+	// sorted union of the triangles of all sections in the column
+	void column(int chunkX, int chunkZ, std::vector<uint32_t>& out) const;
+
+	// [min, max) of the sections holding triangles, min == max if the column is empty
+	std::pair<int, int> sectionRange(int chunkX, int chunkZ) const;
+};
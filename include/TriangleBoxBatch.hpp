@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <PreparedTriangle.hpp>
+
+// Tests one prepared triangle against a batch of unit voxels whose centers are given as structure of
+// arrays (relative to the triangle's anchor). Every kernel gives the result of PreparedTriangle::overlapsVoxel.
+namespace TriangleBoxBatch {
+
+	// overlaps[i] = triangle.overlapsVoxel({ centerX[i], centerY[i], centerZ[i] })
+	using Kernel = void(*)(const PreparedTriangle& triangle,
+		const float* centerX, const float* centerY, const float* centerZ, size_t count, uint8_t* overlaps);
+
+	void scalar(const PreparedTriangle&, const float* centerX, const float* centerY, const float* centerZ, size_t count, uint8_t* overlaps);
+
+	void avx2(const PreparedTriangle&, const float* centerX, const float* centerY, const float* centerZ, size_t count, uint8_t* overlaps);
+
+	void avx512(const PreparedTriangle&, const float* centerX, const float* centerY, const float* centerZ, size_t count, uint8_t* overlaps);
+
+	// widest kernel the executing cpu supports
+	Kernel select();
+
+	const char* name(Kernel);
+}
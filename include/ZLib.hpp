@@ -3,6 +3,11 @@
 #include <string>
 #include <stdexcept>
 
+#include <BEreader.hpp>
+#include <BEwriter.hpp>
+
+struct z_stream_s;
+
 namespace ZLib {
 	
 	uint8_t* compress(uint8_t* input, size_t& inputSize);
@@ -11,4 +16,43 @@ namespace ZLib {
 
 	std::string errorToString(int status);
 
+	// Deflates everything written to it block by block, so the uncompressed data never exists as a whole.
+	class DeflateWriter : public BEwriter {
+	private:
+		static const constexpr size_t blockSize = 16384;
+
+		z_stream_s* stream;
+		uint8_t* output;
+		size_t outputSize;
+
+		void deflateBlock(int flush);
+
+	protected:
+		void overflow(size_t required) override;
+
+	public:
+		DeflateWriter();
+		~DeflateWriter();
+
+		// flushes the stream and hands the compressed bytes to the caller who has to delete[] them
+		uint8_t* finish(size_t& size);
+	};
+
+	// Inflates its input block by block as the reader consumes it, so only one block
+	// of uncompressed data is held in memory at any time.
+	class InflateReader : public BEreader {
+	private:
+		static const constexpr size_t blockSize = 16384;
+
+		z_stream_s* stream;
+		uint8_t* block;
+		bool finished;
+
+	protected:
+		void underflow(size_t required) override;
+
+	public:
+		InflateReader(const uint8_t* input, size_t inputSize);
+		~InflateReader();
+	};
 };
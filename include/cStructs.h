@@ -15,3 +15,16 @@ typedef struct {
 	size_t texCoordIndices[3];
 	uint16_t blockID;
 } Triangle;
+
+// whether the triangles of a mesh sample a texture, selects the voxelization kernel
+enum class MeshShading : uint8_t {
+	Flat,
+	Textured,
+	Mixed
+};
+
+// closed range of voxels a triangle's bounds touch, voxel i covers [i, i + 1]
+typedef struct {
+	int min[3];
+	int max[3];
+} VoxelBounds;
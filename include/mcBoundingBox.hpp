@@ -10,7 +10,8 @@ struct mcBoundingBox {
 	const int minChunkX, maxChunkX;
 	const int minChunkZ, maxChunkZ;
 
-	const uint8_t minSectionY, maxSectionY;
+	// covers every world height, sections a chunk's format does not have are skipped by the modifiers
+	const int minSectionY, maxSectionY;
 
 	mcBoundingBox(const vf3& min, const vf3& max) :
 		minRegionX{ static_cast<int>(std::floor(min.x / 512.0f)) },
@@ -21,8 +22,8 @@ struct mcBoundingBox {
 		maxChunkX{ static_cast<int>(std::ceil(max.x / 16.0f)) },
 		minChunkZ{ static_cast<int>(std::floor(min.z / 16.0f)) },
 		maxChunkZ{ static_cast<int>(std::ceil(max.z / 16.0f)) },
-		minSectionY{ static_cast<uint8_t>(std::min(std::max(std::floor(min.y / 16.0f), 0.0f), 16.0f)) },
-		maxSectionY{ static_cast<uint8_t>(std::min(std::max(std::ceil(max.y / 16.0f), 0.0f), 16.0f)) } {}
+		minSectionY{ static_cast<int>(std::min(std::max(std::floor(min.y / 16.0f), -4.0f), 20.0f)) },
+		maxSectionY{ static_cast<int>(std::min(std::max(std::ceil(max.y / 16.0f), -4.0f), 20.0f)) } {}
 
 
 	uint64_t getNumRegions() const {
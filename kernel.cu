@@ -1,21 +1,17 @@
 #include "kernel.cuh"
 
-__constant__ size_t CUDA_minChunkY;
 __constant__ size_t CUDA_lookupSize;
 
 __device__ Vec3* CUDA_vertices;
 __device__ Vec2* CUDA_texCoords;
 __device__ Triangle* CUDA_triangles;
+__device__ VoxelBounds* CUDA_voxelBounds;
 
 __device__ color* CUDA_lookupColors;
 __device__ uint16_t* CUDA_lookupIndices;
 
 namespace CUDA {
 
-	void setMinChunkY(size_t chunkY) {
-		checkCUDA(cudaMemcpyToSymbol(CUDA_minChunkY, (const void*)&chunkY, sizeof(size_t), 0, cudaMemcpyHostToDevice));
-	}
-
 	void setLookupSize(size_t size) {
 		checkCUDA(cudaMemcpyToSymbol(CUDA_lookupSize, (const void*)&size, sizeof(size_t), 0, cudaMemcpyHostToDevice));
 	}
@@ -72,6 +68,13 @@ namespace CUDA {
 		cudaMemcpyToSymbol(CUDA_triangles, &tmp_devicePtr, sizeof(Triangle*));
 	}
 
+	void initVoxelBoundsBuffer(std::vector<VoxelBounds> &buffer) {
+		VoxelBounds* tmp_devicePtr;
+		cudaMalloc(&tmp_devicePtr, buffer.size() * sizeof(VoxelBounds));
+		cudaMemcpy(tmp_devicePtr, buffer.data(), buffer.size() * sizeof(VoxelBounds), cudaMemcpyHostToDevice);
+		cudaMemcpyToSymbol(CUDA_voxelBounds, &tmp_devicePtr, sizeof(VoxelBounds*));
+	}
+
 	void initLookupColorBuffer(std::vector<color> &buffer) {
 		uint8_t* tmp_devicePtr;
 		cudaMalloc(&tmp_devicePtr, buffer.size() * sizeof(uint8_t));
@@ -100,6 +103,10 @@ namespace CUDA {
 		checkCUDA(cudaFree(CUDA_triangles));
 	}
 
+	void freeVoxelBoundsBuffer() {
+		checkCUDA(cudaFree(CUDA_voxelBounds));
+	}
+
 
 	void freeLookupColorBuffer() {
 		checkCUDA(cudaFree(CUDA_lookupColors));
@@ -143,15 +150,6 @@ __device__ float dot(const Vec3& p1, const Vec3& p2) {
 
 //-----------------/ AABB triangle collision /-----------------//
 
-__device__ bool cuda_approxTriBoxOverlap(const Vec3& min, const Vec3& max, const Vec3& v0, const Vec3& v1, const Vec3& v2) {
-	return !((v0.x > max.x && v1.x > max.x && v2.x > max.x) ||
-		(v0.y > max.y && v1.y > max.y && v2.y > max.y) ||
-		(v0.z > max.z && v1.z > max.z && v2.z > max.z) ||
-		(v0.x < min.x&& v1.x < min.x&& v2.x < min.x) ||
-		(v0.y < min.y&& v1.y < min.y&& v2.y < min.y) ||
-		(v0.z < min.z&& v1.z < min.z&& v2.z < min.z));
-}
-
 __device__ void cuda_findMinMax(float x0, float x1, float x2, float& min, float& max) {
 	min = max = x0;
 	if (x1 < min)
@@ -377,27 +375,39 @@ __device__ bool cuda_triBoxOverlap(const Vec3& boxcenter, const Vec3& boxhalfsiz
 
 //-----------------/ main kernel /-----------------//
 
-__global__ void chunkInserter(const size_t* indexBuffer, const size_t numIndices, cudaTextureObject_t tex, uint16_t* blockBuffer, const int chunkX, const int chunkZ) {
+// instantiated per mesh shading, only mixed meshes check the material of each hit
+template<MeshShading shading>
+__global__ void chunkInserter(const size_t* indexBuffer, const size_t numIndices, cudaTextureObject_t tex, uint16_t* blockBuffer, const int chunkX, const int minChunkY, const int chunkZ) {
 
 	const size_t index = (size_t)threadIdx.x + (size_t)blockIdx.x * (size_t)blockDim.x;
 
 	const Vec3 boxCenter = {
 		chunkX * 16.0f + index % 16 + 0.5f,
-		(index / 4096 + CUDA_minChunkY) * 16.0f + (index % 4096) / 256 + 0.5f,
+		(static_cast<int>(index / 4096) + minChunkY) * 16.0f + (index % 4096) / 256 + 0.5f,
 		chunkZ * 16.0f + (index / 16) % 16 + 0.5f
 	};
 
+	const int voxel[3] = {
+		chunkX * 16 + static_cast<int>(index % 16),
+		(static_cast<int>(index / 4096) + minChunkY) * 16 + static_cast<int>((index % 4096) / 256),
+		chunkZ * 16 + static_cast<int>((index / 16) % 16)
+	};
+
 	const Vec3 boxHalfSize = { 0.5f, 0.5f, 0.5f };
-	const Vec3 boxMin = sub(boxCenter, boxHalfSize);
-	const Vec3 boxMax = add(boxCenter, boxHalfSize);
 
 	for (size_t i = 0; i < numIndices; i++) {
 		const Triangle* tri = &CUDA_triangles[indexBuffer[i]];
+		const VoxelBounds& bounds = CUDA_voxelBounds[indexBuffer[i]];
 
-		if (cuda_approxTriBoxOverlap(boxMin, boxMax, CUDA_vertices[tri->vertexIndices[0]], CUDA_vertices[tri->vertexIndices[1]], CUDA_vertices[tri->vertexIndices[2]]) &&
-			cuda_triBoxOverlap(boxCenter, boxHalfSize, CUDA_vertices[tri->vertexIndices[0]], CUDA_vertices[tri->vertexIndices[1]], CUDA_vertices[tri->vertexIndices[2]])){
+		// integer bounds replace the approximate float test
+		if (voxel[0] < bounds.min[0] || voxel[0] > bounds.max[0] ||
+			voxel[1] < bounds.min[1] || voxel[1] > bounds.max[1] ||
+			voxel[2] < bounds.min[2] || voxel[2] > bounds.max[2])
+			continue;
 
-			if (tri->blockID == UINT16_MAX) {
+		if (cuda_triBoxOverlap(boxCenter, boxHalfSize, CUDA_vertices[tri->vertexIndices[0]], CUDA_vertices[tri->vertexIndices[1]], CUDA_vertices[tri->vertexIndices[2]])){
+
+			if (shading == MeshShading::Textured || (shading == MeshShading::Mixed && tri->blockID == UINT16_MAX)) {
 				const Vec3 s = sub(CUDA_vertices[tri->vertexIndices[1]], CUDA_vertices[tri->vertexIndices[0]]);
 
 				const Vec3 t = sub(CUDA_vertices[tri->vertexIndices[2]], CUDA_vertices[tri->vertexIndices[0]]);
@@ -441,7 +451,17 @@ __global__ void chunkInserter(const size_t* indexBuffer, const size_t numIndices
 }
 
 namespace CUDA {
-	void insertBlocks(size_t numBlocks, size_t numThreads, size_t* indexBuffer, size_t numIndices, cudaTextureObject_t tex, uint16_t* blockBuffer, int chunkX, int chunkZ) {
-		chunkInserter <<<numBlocks, numThreads>>> (indexBuffer, numIndices, tex, blockBuffer, chunkX, chunkZ);
+	void insertBlocks(size_t numBlocks, size_t numThreads, MeshShading shading, size_t* indexBuffer, size_t numIndices, cudaTextureObject_t tex, uint16_t* blockBuffer, int chunkX, int minChunkY, int chunkZ) {
+		switch (shading) {
+		case MeshShading::Flat:
+			chunkInserter<MeshShading::Flat> <<<numBlocks, numThreads>>> (indexBuffer, numIndices, tex, blockBuffer, chunkX, minChunkY, chunkZ);
+			break;
+		case MeshShading::Textured:
+			chunkInserter<MeshShading::Textured> <<<numBlocks, numThreads>>> (indexBuffer, numIndices, tex, blockBuffer, chunkX, minChunkY, chunkZ);
+			break;
+		case MeshShading::Mixed:
+			chunkInserter<MeshShading::Mixed> <<<numBlocks, numThreads>>> (indexBuffer, numIndices, tex, blockBuffer, chunkX, minChunkY, chunkZ);
+			break;
+		}
 	}
 }
@@ -23,9 +23,8 @@ inline void checkCUDAerror(const cudaError status, const char* file, int line, b
 }
 
 namespace CUDA {
-	void insertBlocks(size_t numBlocks, size_t numThreads, size_t* indexBuffer, size_t numIndices, cudaTextureObject_t tex, uint16_t* blockBuffer, int chunkX, int chunkZ);
+	void insertBlocks(size_t numBlocks, size_t numThreads, MeshShading shading, size_t* indexBuffer, size_t numIndices, cudaTextureObject_t tex, uint16_t* blockBuffer, int chunkX, int minChunkY, int chunkZ);
 	
-	void setMinChunkY(size_t v);
 	void setLookupSize(size_t v);
 
 	cudaTextureObject_t* createTexture(Image&);
@@ -33,12 +32,14 @@ namespace CUDA {
 	void initVertexBuffer(std::vector<Vec3> &buffer);
 	void initTexCoordBuffer(std::vector<Vec2> &buffer);
 	void initTriangleBuffer(std::vector<Triangle> &buffer);
+	void initVoxelBoundsBuffer(std::vector<VoxelBounds> &buffer);
 	void initLookupColorBuffer(std::vector<color> &buffer);
 	void initLookupIndexBuffer(std::vector<uint16_t> &buffer);
 
 	void freeVertexBuffer();
 	void freeTexCoordBuffer();
 	void freeTriangleBuffer();
+	void freeVoxelBoundsBuffer();
 	void freeLookupColorBuffer();
 	void freeLookupIndexBuffer();
 }
@@ -4,9 +4,10 @@
 #include <ArgParser.hpp>
 
 #include "ChunkModifier_CPU.hpp"
+#include "ChunkModifier_CPUBatched.hpp"
 #include "ChunkModifier_GPU.hpp"
 
-void insertOBJ(const std::string&, const std::string&, OBJ&, uint32_t, bool);
+void insertOBJ(const std::string&, const std::string&, OBJ&, uint32_t, const std::string&, int32_t);
 
 int main(int argc, char* argv[]) {
 
@@ -14,7 +15,9 @@ int main(int argc, char* argv[]) {
 
 	std::string inputDir, outputDir;
 	int numThreads = 1;
+	std::string backend;
 	bool useCUDA = false;
+	int dataVersion = Chunk::defaultDataVersion;
 	OBJ model;
 	
 	ArgParser args(argc, argv);
@@ -45,7 +48,18 @@ int main(int argc, char* argv[]) {
 		args.parseVec("rotate", false, std::bind(&OBJ::rotate, &model, std::placeholders::_1));
 		args.parseVec("translate", false, std::bind(&OBJ::translate, &model, std::placeholders::_1));
 
+		args.parse("backend", false, backend);
 		args.parse("CUDA", false, useCUDA);
+		args.parse("dataVersion", false, dataVersion);
+
+		// -CUDA is kept as an alias of -backend cuda
+		if (useCUDA)
+			backend = "cuda";
+		else if (backend.empty())
+			backend = "cpu";
+
+		if (backend != "cpu" && backend != "cpu-batched" && backend != "cuda")
+			throw std::invalid_argument("unknown backend \"" + backend + "\" (cpu, cpu-batched or cuda)");
 		
 	} catch (const std::exception& e) {
 		Logger::error("[argument_parsing_error] " + std::string(e.what()));
@@ -53,14 +67,14 @@ int main(int argc, char* argv[]) {
 	}
 
 	try {
-		insertOBJ(inputDir, outputDir, model, numThreads, useCUDA);
+		insertOBJ(inputDir, outputDir, model, numThreads, backend, dataVersion);
 	} catch (const std::exception& e) {
 		Logger::error(e.what());
 	}
 }
 
 
-void insertOBJ(const std::string& inputDir, const std::string& outputDir, OBJ& object, uint32_t numThreads, bool useCUDA) {
+void insertOBJ(const std::string& inputDir, const std::string& outputDir, OBJ& object, uint32_t numThreads, const std::string& backend, int32_t dataVersion) {
 
 	Logger::log("calculating bounding box... ");
 
@@ -72,7 +86,13 @@ void insertOBJ(const std::string& inputDir, const std::string& outputDir, OBJ& o
 
 	Logger::log("inititalizing modifier... ");
 
-	ChunkModifier* instance = (useCUDA ? ChunkModifier_GPU::init : ChunkModifier_CPU::init)(object, approxSize);
+	ChunkModifier* (*init)(OBJ&, const mcBoundingBox&, uint32_t) = ChunkModifier_CPU::init;
+	if (backend == "cpu-batched")
+		init = ChunkModifier_CPUBatched::init;
+	else if (backend == "cuda")
+		init = ChunkModifier_GPU::init;
+
+	ChunkModifier* instance = init(object, approxSize, numThreads);
 
 
 	Logger::log("launching workerthreads... ");
@@ -96,7 +116,7 @@ void insertOBJ(const std::string& inputDir, const std::string& outputDir, OBJ& o
 		});
 	}
 	
-	std::thread reassmebler(ChunkModifier::reassembleRegions, &outputBuffer, outputDir, numChunks, &waitForModification);
+	std::thread reassmebler(ChunkModifier::reassembleRegions, &outputBuffer, inputDir, outputDir, numChunks, &waitForModification);
 
 
 	Logger::log("loading chunks... ");
@@ -104,7 +124,7 @@ void insertOBJ(const std::string& inputDir, const std::string& outputDir, OBJ& o
 	for (int regionX = approxSize.minRegionX; regionX <= approxSize.maxRegionX; regionX++) {
 		for (int regionZ = approxSize.minRegionZ; regionZ <= approxSize.maxRegionZ; regionZ++) {
 			std::string filename = inputDir + "r." + std::to_string(regionX) + "." + std::to_string(regionZ) + ".mca";
-			Region::loadMCAtoBuffer(filename, regionX, regionZ, minOBJ, maxOBJ, inputBuffer, outputBuffer);
+			Region::loadMCAtoBuffer(filename, regionX, regionZ, minOBJ, maxOBJ, inputBuffer, outputBuffer, dataVersion);
 		}
 	}
 
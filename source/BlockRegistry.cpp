@@ -0,0 +1,84 @@
+#include <BlockRegistry.hpp>
+
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+	struct Table {
+		std::shared_mutex mtx;
+		std::deque<InternedString> names;
+		std::unordered_map<InternedString, uint16_t> ids;
+	};
+
+	// function local so blocks can be registered during static initialization
+	Table& table() {
+		static Table instance;
+		return instance;
+	}
+}
+
+
+uint16_t BlockRegistry::id(const InternedString& name) {
+	Table& t = table();
+
+	{
+		std::shared_lock<std::shared_mutex> lock(t.mtx);
+		auto it = t.ids.find(name);
+		if (it != t.ids.end())
+			return it->second;
+	}
+
+	std::unique_lock<std::shared_mutex> lock(t.mtx);
+	auto it = t.ids.find(name);
+	if (it != t.ids.end())
+		return it->second;
+
+	if (t.names.size() >= none)
+		throw std::runtime_error("[block_registry_error] cannot register \"" + name.string() + "\", all block IDs are taken");
+
+	const uint16_t id = static_cast<uint16_t>(t.names.size());
+	t.names.push_back(name);
+	t.ids.insert({ name, id });
+
+	return id;
+}
+
+uint16_t BlockRegistry::find(const InternedString& name) {
+	Table& t = table();
+	std::shared_lock<std::shared_mutex> lock(t.mtx);
+	auto it = t.ids.find(name);
+	return it != t.ids.end() ? it->second : none;
+}
+
+InternedString BlockRegistry::name(uint16_t id) {
+	Table& t = table();
+	std::shared_lock<std::shared_mutex> lock(t.mtx);
+	if (id >= t.names.size())
+		throw std::out_of_range("[block_registry_error] unknown block ID " + std::to_string(id));
+	return t.names[id];
+}
+
+size_t BlockRegistry::size() {
+	Table& t = table();
+	std::shared_lock<std::shared_mutex> lock(t.mtx);
+	return t.names.size();
+}
+
+void BlockRegistry::loadList(const std::string& filename) {
+	std::ifstream fileIn(filename);
+
+	if (!fileIn)
+		throw std::runtime_error("[block_parser_error] cannot find file \"" + filename + "\"");
+
+	std::string line;
+	while (std::getline(fileIn, line)) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (!line.empty())
+			id(line);
+	}
+}
@@ -0,0 +1,122 @@
+#include <SectionCodec.hpp>
+
+#include <CPUFeatures.hpp>
+
+#include <array>
+
+#ifdef CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+// The padded packing stores 64 / bits entries per long, so a long is expanded (or assembled) with one
+// variable shift per entry from a table that is built per width at compile time. Lanes past the last
+// entry shift by 64, which clears them. The last longs are left to the scalar loop, because a long
+// reads and writes up to 16 entries.
+
+namespace {
+
+	template<uint32_t bits>
+	constexpr std::array<uint64_t, 16> entryShifts() {
+		std::array<uint64_t, 16> shifts{};
+		for (size_t j = 0; j < 16; j++)
+			shifts[j] = j < 64 / bits ? j * bits : 64;
+		return shifts;
+	}
+
+	template<uint32_t bits>
+	constexpr size_t firstScalarLong() {
+		return (4096 - 16) / (64 / bits) + 1;
+	}
+
+#ifdef CPU_FEATURES_X86
+
+	template<uint32_t bits>
+	TARGET_AVX2 void unpackAVX2(const int64_t* longs, uint16_t* indices) {
+		constexpr size_t blocksPerLong = 64 / bits;
+		constexpr size_t numPairs = (blocksPerLong + 7) / 8;
+		static constexpr std::array<uint64_t, 16> shifts = entryShifts<bits>();
+
+		const __m256i mask = _mm256_set1_epi64x((1LL << bits) - 1);
+		const __m256i low32 = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+		__m256i shiftVectors[2 * numPairs];
+		for (size_t g = 0; g < 2 * numPairs; g++)
+			shiftVectors[g] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&shifts[4 * g]));
+
+		for (size_t l = 0; l < firstScalarLong<bits>(); l++) {
+			const __m256i value = _mm256_set1_epi64x(longs[l]);
+			uint16_t* out = indices + l * blocksPerLong;
+
+			// two groups of 4 entries are narrowed to 16 bit and stored together
+			for (size_t p = 0; p < numPairs; p++) {
+				const __m256i a = _mm256_and_si256(_mm256_srlv_epi64(value, shiftVectors[2 * p]), mask);
+				const __m256i b = _mm256_and_si256(_mm256_srlv_epi64(value, shiftVectors[2 * p + 1]), mask);
+				const __m128i a32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(a, low32));
+				const __m128i b32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(b, low32));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8 * p), _mm_packus_epi32(a32, b32));
+			}
+		}
+
+		BlockStatesCodec<BlockStatesPacking::Padded>::unpack(longs, std::integral_constant<uint32_t, bits>{}, indices, firstScalarLong<bits>());
+	}
+
+	template<uint32_t bits>
+	TARGET_AVX2 void packAVX2(const uint16_t* indices, int64_t* longs) {
+		constexpr size_t blocksPerLong = 64 / bits;
+		constexpr size_t numGroups = (blocksPerLong + 3) / 4;
+		static constexpr std::array<uint64_t, 16> shifts = entryShifts<bits>();
+
+		__m256i shiftVectors[numGroups];
+		for (size_t g = 0; g < numGroups; g++)
+			shiftVectors[g] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&shifts[4 * g]));
+
+		for (size_t l = 0; l < firstScalarLong<bits>(); l++) {
+			const uint16_t* in = indices + l * blocksPerLong;
+
+			__m256i value = _mm256_setzero_si256();
+			for (size_t g = 0; g < numGroups; g++) {
+				const __m256i entries = _mm256_cvtepu16_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + 4 * g)));
+				value = _mm256_or_si256(value, _mm256_sllv_epi64(entries, shiftVectors[g]));
+			}
+
+			__m128i folded = _mm_or_si128(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+			folded = _mm_or_si128(folded, _mm_unpackhi_epi64(folded, folded));
+			longs[l] = _mm_cvtsi128_si64(folded);
+		}
+
+		BlockStatesCodec<BlockStatesPacking::Padded>::pack(indices, std::integral_constant<uint32_t, bits>{}, longs, firstScalarLong<bits>());
+	}
+
+#endif
+}
+
+
+bool BlockStatesCodec<BlockStatesPacking::Padded>::unpackAVX2(const int64_t* longs, uint32_t bitsPerBlock, uint16_t* indices) {
+	bool done = false;
+#ifdef CPU_FEATURES_X86
+	if (CPUFeatures::get().avx2) {
+		withBitsPerBlock(bitsPerBlock, [&](auto bits) {
+			if constexpr (!std::is_same_v<decltype(bits), uint32_t>) {
+				::unpackAVX2<decltype(bits)::value>(longs, indices);
+				done = true;
+			}
+		});
+	}
+#endif
+	return done;
+}
+
+bool BlockStatesCodec<BlockStatesPacking::Padded>::packAVX2(const uint16_t* indices, uint32_t bitsPerBlock, int64_t* longs) {
+	bool done = false;
+#ifdef CPU_FEATURES_X86
+	if (CPUFeatures::get().avx2) {
+		withBitsPerBlock(bitsPerBlock, [&](auto bits) {
+			if constexpr (!std::is_same_v<decltype(bits), uint32_t>) {
+				::packAVX2<decltype(bits)::value>(indices, longs);
+				done = true;
+			}
+		});
+	}
+#endif
+	return done;
+}
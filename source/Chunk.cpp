@@ -1,44 +1,63 @@
 #include "Chunk.hpp"
 
-Chunk Chunk::create(chunkType type, int x, int z) {
+Chunk Chunk::create(chunkType type, int x, int z, int32_t dataVersion) {
 
 	if (type == chunkType::VANILLA) {
-		
-		NBTlongArray heightmap(37);
-		std::fill(heightmap.begin(), heightmap.end(), 1137128059338260031LL);
-
-		NBT nbt = NBTcompound{
-			{ "DataVersion", 2586 },
-			{ "Level",
-				NBTcompound{
-					{ "xPos", x / 16 },
-					{ "zPos", z / 16 },
-					{ "Sections", NBTlist{} },
-					{ "Heightmaps",
-						NBTcompound{
-							{ "OCEAN_FLOOR", NBTlongArray{} },
-							{ "MOTION_BLOCKING_NO_LEAVES", NBTlongArray{} },
-							{ "MOTION_BLOCKING", NBTlongArray{} },
-							{ "WORLD_SURFACE", NBTlongArray(37,  1137128059338260031LL) },
+
+		NBT nbt;
+
+		if (dataVersion >= 2844) {
+			// 21w43a moved the level contents to the root and extended the world to Y -64
+			nbt = NBTcompound{
+				{ "DataVersion", dataVersion },
+				{ "xPos", x / 16 },
+				{ "yPos", -4 },
+				{ "zPos", z / 16 },
+				{ "sections", NBTlist{} },
+				{ "Heightmaps", NBTcompound{} },
+				{ "block_entities", NBTlist{} },
+				{ "structures", NBTcompound{} },
+				{ "InhabitedTime", int64_t(0) },
+				{ "LastUpdate", int64_t(0) },
+				{ "Status", NBTstring("full") }
+			};
+		} else {
+			nbt = NBTcompound{
+				{ "DataVersion", dataVersion },
+				{ "Level",
+					NBTcompound{
+						{ "xPos", x / 16 },
+						{ "zPos", z / 16 },
+						{ "Sections", NBTlist{} },
+						{ "Heightmaps",
+							NBTcompound{
+								{ "OCEAN_FLOOR", NBTlongArray{} },
+								{ "MOTION_BLOCKING_NO_LEAVES", NBTlongArray{} },
+								{ "MOTION_BLOCKING", NBTlongArray{} },
+								{ "WORLD_SURFACE", NBTlongArray(37,  1137128059338260031LL) },
+							}
 						}
-					}
+					},
 				},
-			},
-			{ "CarvingMasks", NBTcompound{} },
-			{ "Entities", NBTlist{} },
-			{ "TileEntities", NBTlist{} },
-			{ "TileTicks", NBTlist{} },
-			{ "ToBeTicked", NBTlist{} },
-			{ "Structures", NBTcompound{} },
-			{ "InhabitedTime", 0LL },
-			{ "LastUpdate", 0LL },
-			{ "Status", NBTstring("full") }
-		};
+				{ "CarvingMasks", NBTcompound{} },
+				{ "Entities", NBTlist{} },
+				{ "TileEntities", NBTlist{} },
+				{ "TileTicks", NBTlist{} },
+				{ "ToBeTicked", NBTlist{} },
+				{ "Structures", NBTcompound{} },
+				{ "InhabitedTime", int64_t(0) },
+				{ "LastUpdate", int64_t(0) },
+				{ "Status", NBTstring("full") }
+			};
+		}
 		
 		size_t dataSize;
 		uint8_t* data = nbt.serialize(dataSize);
 
-		return Chunk(chunkType::VANILLA, x, z, data, dataSize, false);
+		// the region file has no such chunk, so it counts as modified
+		Chunk chunk(chunkType::VANILLA, x, z, data, dataSize, false);
+		chunk.modified = true;
+		return chunk;
 	} else {
 		throw std::invalid_argument("This type of chunk has not been implemented yet");
 	}
@@ -49,6 +68,7 @@ Chunk::Chunk(const Chunk& chunk) {
 	this->x = chunk.x;
 	this->z = chunk.z;
 	this->compressed = chunk.compressed;
+	this->modified = chunk.modified;
 	this->dataSize = chunk.dataSize;
 	
 	if (chunk.data) {
@@ -62,6 +82,7 @@ Chunk::Chunk(Chunk&& chunk) noexcept {
 	this->x = chunk.x;
 	this->z = chunk.z;
 	this->compressed = chunk.compressed;
+	this->modified = chunk.modified;
 	this->dataSize = chunk.dataSize;
 	this->data = chunk.data;
 	
@@ -75,6 +96,7 @@ Chunk& Chunk::operator=(const Chunk& chunk) {
 	x = chunk.x;
 	z = chunk.z;
 	compressed = chunk.compressed;
+	modified = chunk.modified;
 	dataSize = chunk.dataSize;
 
 	if (chunk.data) {
@@ -94,6 +116,7 @@ Chunk& Chunk::operator=(Chunk&& chunk) noexcept {
 		this->x = chunk.x;
 		this->z = chunk.z;
 		this->compressed = chunk.compressed;
+		this->modified = chunk.modified;
 		this->dataSize = chunk.dataSize;
 		this->data = chunk.data;
 
@@ -120,12 +143,33 @@ void Chunk::uncompress() {
 }
 
 NBT Chunk::getNBT() {
-	return std::move(NBT::parse(data, dataSize));
+	if (compressed) {
+		ZLib::InflateReader is(data, dataSize);
+		return NBT::parse(is);
+	}
+	return NBT::parse(data, dataSize);
+}
+
+NBT Chunk::getNBT(const std::vector<std::string>& paths, bool keepRest) {
+	if (compressed) {
+		ZLib::InflateReader is(data, dataSize);
+		return NBT::parse(is, paths, keepRest);
+	}
+	BEbufferReader is(data, dataSize);
+	return NBT::parse(is, paths, keepRest);
 }
 
-void Chunk::setNBT(const NBT& nbt) {
+void Chunk::setNBT(const NBT& nbt, bool compress) {
 	clean();
-	data = nbt.serialize(dataSize);
+	if (compress) {
+		ZLib::DeflateWriter os;
+		nbt.serialize(os);
+		data = os.finish(dataSize);
+	} else {
+		data = nbt.serialize(dataSize);
+	}
+	compressed = compress;
+	modified = true;
 }
 
 std::string Chunk::toString() {
@@ -0,0 +1,88 @@
+#include <ChunkSchema.hpp>
+
+
+ChunkSections::ChunkSections(NBTcompound& root, const SectionCodec& _codec) :
+	codec{ _codec },
+	level{ _codec.level(root) },
+	list{ _codec.sections(level) } {
+
+	sections.reserve(list.size());
+	for (NBT& nbt : list) {
+		// malformed sections are left alone instead of failing the whole chunk
+		NBTcompound* section = nbt.try_get<NBTcompound>();
+		const int8_t* y = section ? ChunkSchema::Y.find(*section) : nullptr;
+		if (y) {
+			sections.push_back({ *y, section, nullptr, nullptr });
+		}
+	}
+}
+
+void ChunkSections::setPosition(int32_t chunkX, int32_t chunkZ) {
+	ChunkSchema::xPos.set(level, chunkX);
+	ChunkSchema::zPos.set(level, chunkZ);
+}
+
+ChunkSections::Section* ChunkSections::find(int8_t y) {
+	for (Section& section : sections) {
+		if (section.y == y) {
+			// resolved on first access so sections that are never touched stay encoded
+			if (!section.palette)
+				section.palette = codec.findPalette(*section.compound);
+			if (!section.blockStates)
+				section.blockStates = codec.findBlockStates(*section.compound);
+			return &section;
+		}
+	}
+	return nullptr;
+}
+
+ChunkSections::Section& ChunkSections::getOrCreate(int8_t y) {
+	Section* section = find(y);
+
+	if (!section) {
+		list.push_back(NBTcompound{
+			{ ChunkSchema::Y.key, y },
+			{ ChunkSchema::BlockLight.key, NBTbyteArray(2048, 1) }
+		});
+		sections.push_back({ y, &static_cast<NBTcompound&>(list.back()), nullptr, nullptr });
+		section = &sections.back();
+	}
+
+	if (!section->palette) {
+		section->palette = &codec.getOrInsertPalette(*section->compound);
+	}
+
+	if (!section->blockStates) {
+		section->blockStates = &codec.getOrInsertBlockStates(*section->compound);
+	}
+
+	if (section->blockStates->empty()) {
+		section->blockStates->resize(codec.numLongs(section->palette->size()), 0);
+	}
+
+	return *section;
+}
+
+NBTlongArray& ChunkSections::blockStates(Section& section) const {
+	if (!section.blockStates)
+		section.blockStates = &codec.getOrInsertBlockStates(*section.compound);
+	return *section.blockStates;
+}
+
+void ChunkSections::unpack(const Section& section, uint16_t* indices) const {
+	static const NBTlongArray empty;
+	codec.unpack(section.blockStates ? *section.blockStates : empty, section.palette ? section.palette->size() : 0, indices);
+}
+
+void ChunkSections::pack(Section& section, const uint16_t* indices) const {
+	codec.pack(indices, section.palette->size(), blockStates(section));
+}
+
+void ChunkSections::get(const Section& section, const uint16_t* positions, size_t count, uint16_t* indices) const {
+	static const NBTlongArray empty;
+	codec.get(section.blockStates ? *section.blockStates : empty, section.palette ? section.palette->size() : 0, positions, count, indices);
+}
+
+void ChunkSections::set(Section& section, const uint16_t* positions, const uint16_t* indices, size_t count) const {
+	codec.set(blockStates(section), section.palette->size(), positions, indices, count);
+}
@@ -0,0 +1,30 @@
+#include <InternedString.hpp>
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+const std::string* InternedString::intern(std::string_view s) {
+	// function local so keys can be interned during static initialization
+	static std::shared_mutex mtx;
+	static std::deque<std::string> strings;
+	static std::unordered_map<std::string_view, const std::string*> lookup;
+
+	{
+		std::shared_lock<std::shared_mutex> lock(mtx);
+		auto it = lookup.find(s);
+		if (it != lookup.end())
+			return it->second;
+	}
+
+	std::unique_lock<std::shared_mutex> lock(mtx);
+	auto it = lookup.find(s);
+	if (it != lookup.end())
+		return it->second;
+
+	const std::string* str = &strings.emplace_back(s);
+	lookup.insert({ *str, str });
+
+	return str;
+}
@@ -1,8 +1,20 @@
 #include <NBT.hpp>
 
 #include <functional>
+#include <algorithm>
 #include <string.h>
 
+// overload set for std::visit
+template<typename... Ts>
+struct overloaded : Ts... { using Ts::operator()...; };
+
+template<typename... Ts>
+overloaded(Ts...) -> overloaded<Ts...>;
+
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<size_t>(NBTtagType::Compound), NBTvalue>, NBTcompoundBox>);
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<size_t>(NBTtagType::LongArray), NBTvalue>, NBTlongArray>);
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<size_t>(NBTtagType::Boolean), NBTvalue>, bool>);
+
 std::string NBT::typeToString(NBTtagType type) {
 	switch (type) {
 	case NBTtagType::Boolean:	return "Boolean";
@@ -18,6 +30,7 @@ std::string NBT::typeToString(NBTtagType type) {
 	case NBTtagType::LongArray:	return "LongArray";
 	case NBTtagType::List:		return "List";
 	case NBTtagType::Compound:	return "Compound";
+	case NBTtagType::raw:		return "raw";
 	case NBTtagType::null:		return "null";
 	case NBTtagType::end:		return "end";
 	default: return std::string("invalid NBT type ") + std::to_string(static_cast<uint8_t>(type));
@@ -25,138 +38,157 @@ std::string NBT::typeToString(NBTtagType type) {
 }
 
 
-//--------------/ constructors /--------------//
+//--------------/ compound box /--------------//
 
-NBT::NBT() : type(NBTtagType::null) {
-	data.String = nullptr;
-}
+NBTcompoundBox::NBTcompoundBox() : compound(std::make_unique<NBTcompound>()) {}
 
-NBT::NBT(bool b) : type(NBTtagType::Boolean) {
-	data.Boolean = b;
-}
+NBTcompoundBox::NBTcompoundBox(const NBTcompound& c) : compound(std::make_unique<NBTcompound>(c)) {}
 
-NBT::NBT(int8_t b) : type(NBTtagType::Byte) {
-	data.Byte = b;
-}
+NBTcompoundBox::NBTcompoundBox(NBTcompound&& c) : compound(std::make_unique<NBTcompound>(std::move(c))) {}
 
-NBT::NBT(int16_t s) : type(NBTtagType::Short) {
-	data.Short = s;
-}
+NBTcompoundBox::NBTcompoundBox(const NBTcompoundBox& box) : compound(std::make_unique<NBTcompound>(*box.compound)) {}
 
-NBT::NBT(int32_t i) : type(NBTtagType::Int) {
-	data.Int = i;
-}
+NBTcompoundBox::~NBTcompoundBox() = default;
 
-NBT::NBT(int64_t i) : type(NBTtagType::Long) {
-	data.Long = i;
+NBTcompoundBox& NBTcompoundBox::operator=(const NBTcompoundBox& box) {
+	compound = std::make_unique<NBTcompound>(*box.compound);
+	return *this;
 }
 
-NBT::NBT(float f) : type(NBTtagType::Float) {
-	data.Float = f;
-}
+NBTcompoundBox& NBTcompoundBox::operator=(NBTcompoundBox&& box) noexcept = default;
 
-NBT::NBT(double d) : type(NBTtagType::Double) {
-	data.Double = d;
-}
 
-NBT::NBT(const NBTstring& s) : type(NBTtagType::String) {
-	data.String = new NBTstring(s);
-}
+//--------------/ constructors /--------------//
 
-NBT::NBT(const NBTbyteArray& v) : type(NBTtagType::ByteArray) {
-	data.ByteArray = new NBTbyteArray(v);
-}
+NBT::NBT() {}
 
-NBT::NBT(const NBTintArray& v) : type(NBTtagType::IntArray) {
-	data.IntArray = new NBTintArray(v);
-}
+NBT::NBT(bool b) : value(std::in_place_type<bool>, b) {}
 
-NBT::NBT(const NBTlongArray& v) : type(NBTtagType::LongArray) {
-	data.LongArray = new NBTlongArray(v);
-}
+NBT::NBT(int8_t b) : value(std::in_place_type<int8_t>, b) {}
 
-NBT::NBT(const NBTlist& v) : type(NBTtagType::List) {
-	data.List = new NBTlist(v);
-}
+NBT::NBT(int16_t s) : value(std::in_place_type<int16_t>, s) {}
 
-NBT::NBT(const NBTcompound& c) : type(NBTtagType::Compound) {
-	data.Compound = new NBTcompound(c);
-}
+NBT::NBT(int32_t i) : value(std::in_place_type<int32_t>, i) {}
 
+NBT::NBT(int64_t i) : value(std::in_place_type<int64_t>, i) {}
 
-NBT::NBT(NBTstring&& s) : type(NBTtagType::String) {
-	data.String = new NBTstring(std::move(s));
-}
+NBT::NBT(float f) : value(std::in_place_type<float>, f) {}
 
-NBT::NBT(NBTbyteArray&& v) : type(NBTtagType::ByteArray) {
-	data.ByteArray = new NBTbyteArray(std::move(v));
-}
+NBT::NBT(double d) : value(std::in_place_type<double>, d) {}
 
-NBT::NBT(NBTintArray&& v) : type(NBTtagType::IntArray) {
-	data.IntArray = new NBTintArray(std::move(v));
-}
+NBT::NBT(const NBTstring& s) : value(std::in_place_type<NBTstring>, s) {}
 
-NBT::NBT(NBTlongArray&& v) : type(NBTtagType::LongArray) {
-	data.LongArray = new NBTlongArray(std::move(v));
-}
+NBT::NBT(const NBTbyteArray& v) : value(std::in_place_type<NBTbyteArray>, v) {}
 
-NBT::NBT(NBTlist&& v) : type(NBTtagType::List) {
-	data.List = new NBTlist(std::move(v));
-}
+NBT::NBT(const NBTintArray& v) : value(std::in_place_type<NBTintArray>, v) {}
 
-NBT::NBT(NBTcompound&& m) : type(NBTtagType::Compound) {
-	data.Compound = new NBTcompound(std::move(m));
-}
+NBT::NBT(const NBTlongArray& v) : value(std::in_place_type<NBTlongArray>, v) {}
 
+NBT::NBT(const NBTlist& v) : value(std::in_place_type<NBTlist>, v) {}
 
-NBT::NBT(const NBT& nbt) {
-	this->type = nbt.type;
-	this->data = nbt.data;
+NBT::NBT(const NBTcompound& c) : value(std::in_place_type<NBTcompoundBox>, c) {}
 
-	switch (type) {
-	case NBTtagType::String:
-		data.String		= new NBTstring(*data.String);			break;
-	case NBTtagType::ByteArray:
-		data.ByteArray	= new NBTbyteArray(*data.ByteArray);	break;
-	case NBTtagType::IntArray:
-		data.IntArray	= new NBTintArray(*data.IntArray);		break;
-	case NBTtagType::LongArray:
-		data.LongArray	= new NBTlongArray(*data.LongArray);	break;
-	case NBTtagType::List:
-		data.List		= new NBTlist(*data.List);				break;
-	case NBTtagType::Compound:
-		data.Compound	= new NBTcompound(*data.Compound);		break;
-	}
-}
 
-NBT::NBT(NBT&& nbt) noexcept {
-	this->type = nbt.type;
-	this->data = nbt.data;
+NBT::NBT(NBTstring&& s) : value(std::in_place_type<NBTstring>, std::move(s)) {}
 
-	nbt.type = NBTtagType::null;
-	nbt.data.String = nullptr;
-}
+NBT::NBT(NBTbyteArray&& v) : value(std::in_place_type<NBTbyteArray>, std::move(v)) {}
+
+NBT::NBT(NBTintArray&& v) : value(std::in_place_type<NBTintArray>, std::move(v)) {}
+
+NBT::NBT(NBTlongArray&& v) : value(std::in_place_type<NBTlongArray>, std::move(v)) {}
+
+NBT::NBT(NBTlist&& v) : value(std::in_place_type<NBTlist>, std::move(v)) {}
 
-NBT::~NBT() {
-	cleanup();
+NBT::NBT(NBTcompound&& m) : value(std::in_place_type<NBTcompoundBox>, std::move(m)) {}
+
+NBT::NBT(NBTraw&& r) : value(std::in_place_type<NBTraw>, std::move(r)) {}
+
+
+NBT::NBT(const NBT& nbt) : value(nbt.value) {}
+
+NBT::NBT(NBT&& nbt) noexcept : value(std::move(nbt.value)) {
+	nbt.value.emplace<std::monostate>();
 }
 
+NBT::~NBT() = default;
+
 
 //--------------/ parsing /--------------//
 
-NBT NBT::parse(uint8_t* buffer, size_t size) {
-	BEstream is(buffer, size);
+// Tree of requested compound keys built from dot separated paths like "Level.Sections".
+// A node that is requested as a whole parses its complete subtree.
+struct NBTfilter {
+	std::vector<std::pair<InternedString, NBTfilter>> children;
+	bool whole = false;
+	size_t numLeaves = 0;
+
+	const NBTfilter* find(const InternedString& key) const {
+		for (const auto& child : children) {
+			if (child.first == key)
+				return &child.second;
+		}
+		return nullptr;
+	}
+
+	size_t countLeaves() {
+		if (whole) {
+			children.clear();
+			return numLeaves = 1;
+		}
+		numLeaves = 0;
+		for (auto& child : children) {
+			numLeaves += child.second.countLeaves();
+		}
+		return numLeaves;
+	}
+
+	static NBTfilter fromPaths(const std::vector<std::string>& paths) {
+		NBTfilter root;
+		for (const std::string& path : paths) {
+			NBTfilter* node = &root;
+			size_t begin = 0;
+			while (begin <= path.length()) {
+				size_t end = path.find('.', begin);
+				if (end == std::string::npos)
+					end = path.length();
+
+				const InternedString key = std::string_view(path).substr(begin, end - begin);
+				auto it = std::find_if(node->children.begin(), node->children.end(), [&key](const auto& child) { return child.first == key; });
+				if (it == node->children.end()) {
+					node->children.push_back({ key, NBTfilter{} });
+					it = --node->children.end();
+				}
+				node = &it->second;
+				begin = end + 1;
+			}
+			node->whole = true;
+		}
+		root.countLeaves();
+		return root;
+	}
+};
 
-	NBTtagType type = static_cast<NBTtagType>(is.buffer[is.index++]);
+static NBTtagType parseHeader(BEreader& is) {
+	NBTtagType type;
+	is >> type;
 
 	if (type != NBTtagType::Compound && type != NBTtagType::List)
 		throw std::runtime_error(std::string("Invalid NBT type ") + std::to_string(static_cast<uint8_t>(type)));
 
 	uint16_t length;
 	is >> length;
-	is.index += length;
+	is.skip(length);
 
-	if (type == NBTtagType::Compound) {
+	return type;
+}
+
+NBT NBT::parse(uint8_t* buffer, size_t size) {
+	BEbufferReader is(buffer, size);
+	return parse(is);
+}
+
+NBT NBT::parse(BEreader& is) {
+	if (parseHeader(is) == NBTtagType::Compound) {
 		return NBT::parseCompound(is);
 	}
 	else {
@@ -164,12 +196,21 @@ NBT NBT::parse(uint8_t* buffer, size_t size) {
 	}
 }
 
+NBT NBT::parse(BEreader& is, const std::vector<std::string>& paths, bool keepRest) {
+	const NBTfilter filter = NBTfilter::fromPaths(paths);
+	// everything has to be read if the rest is kept
+	size_t pending = keepRest ? SIZE_MAX : filter.numLeaves;
+	return parseFiltered(is, parseHeader(is), filter, pending, keepRest);
+}
+
 const auto NBT::getParser(NBTtagType type) {
 	switch (type) {
 	case NBTtagType::Byte:		return parseByte;
 	case NBTtagType::Short:		return parseShort;
 	case NBTtagType::Int:		return parseInt;
 	case NBTtagType::Long:		return parseLong;
+	case NBTtagType::Float:		return parseFloat;
+	case NBTtagType::Double:	return parseDouble;
 	case NBTtagType::String:	return parseString;
 	case NBTtagType::ByteArray:	return parseByteArray;
 	case NBTtagType::IntArray:	return parseIntArray;
@@ -181,48 +222,62 @@ const auto NBT::getParser(NBTtagType type) {
 	}
 }
 
-NBT NBT::parseByte(BEstream& is) {
-	return static_cast<int8_t>(is.buffer[is.index++]);
+NBT NBT::parseByte(BEreader& is) {
+	int8_t value;
+	is >> value;
+	return value;
 }
 
-NBT NBT::parseBool(BEstream& is) {
-	return static_cast<bool>(is.buffer[is.index++]);
+NBT NBT::parseBool(BEreader& is) {
+	uint8_t value;
+	is >> value;
+	return static_cast<bool>(value);
 }
 
-NBT NBT::parseShort(BEstream& is) {
+NBT NBT::parseShort(BEreader& is) {
 	int16_t value;
 	is >> value;
 	return value;
 }
 
-NBT NBT::parseInt(BEstream& is) {
+NBT NBT::parseInt(BEreader& is) {
 	int32_t value;
 	is >> value;
 	return value;
 }
 
-NBT NBT::parseLong(BEstream& is) {
+NBT NBT::parseLong(BEreader& is) {
 	int64_t value;
 	is >> value;
 	return value;
 }
 
-NBT NBT::parseString(BEstream& is) {
+NBT NBT::parseFloat(BEreader& is) {
+	float value;
+	is >> value;
+	return value;
+}
+
+NBT NBT::parseDouble(BEreader& is) {
+	double value;
+	is >> value;
+	return value;
+}
+
+NBT NBT::parseString(BEreader& is) {
 	NBTstring value;
 	is >> value;
 	return std::move(value);
 }
 
-NBT NBT::parseByteArray(BEstream& is) {
+NBT NBT::parseByteArray(BEreader& is) {
 	uint32_t length; is >> length;
 	NBTbyteArray array(length);
-	for (size_t i = 0; i < length; i++) {
-		is >> array[i];
-	}
+	is.read(reinterpret_cast<uint8_t*>(array.data()), length);
 	return std::move(array);
 }
 
-NBT NBT::parseIntArray(BEstream& is) {
+NBT NBT::parseIntArray(BEreader& is) {
 	uint32_t length; is >> length;
 	NBTintArray array(length);
 	for (size_t i = 0; i < length; i++) {
@@ -231,7 +286,7 @@ NBT NBT::parseIntArray(BEstream& is) {
 	return std::move(array);
 }
 
-NBT NBT::parseLongArray(BEstream& is) {
+NBT NBT::parseLongArray(BEreader& is) {
 	uint32_t length; is >> length;
 	NBTlongArray array(length);
 	for (size_t i = 0; i < length; i++) {
@@ -240,8 +295,8 @@ NBT NBT::parseLongArray(BEstream& is) {
 	return std::move(array);
 }
 
-NBT NBT::parseList(BEstream& is) {
-	NBTtagType contentType = static_cast<NBTtagType>(is.buffer[is.index++]);
+NBT NBT::parseList(BEreader& is) {
+	NBTtagType contentType; is >> contentType;
 	uint32_t length; is >> length;
 	NBTlist list(length);
 
@@ -255,673 +310,420 @@ NBT NBT::parseList(BEstream& is) {
 	return std::move(list);
 }
 
-NBT NBT::parseCompound(BEstream& is) {
+NBT NBT::parseCompound(BEreader& is) {
 	NBTcompound compound;
 	NBTtagType type;
-	while ((type = static_cast<NBTtagType>(is.buffer[is.index++])) != NBTtagType::end) {
-		std::string name; is >> name;
+	std::string buffer;
+	while ((is >> type, type) != NBTtagType::end) {
+		is >> buffer;
+		const InternedString name = buffer;
 		compound.insert({ name, getParser(type)(is) });
 	}
 	return std::move(compound);
 }
 
+NBT NBT::parseFiltered(BEreader& is, NBTtagType type, const NBTfilter& filter, size_t& pending, bool keepRest) {
+	if (type == NBTtagType::Compound) {
+		return parseFilteredCompound(is, filter, pending, keepRest);
 
-//--------------/ size & length /--------------//
-
-size_t NBT::size(bool firstCall) const {
-	
-	size_t size = firstCall ? (sizeof(NBTtagType) + sizeof(uint16_t)) : 0; //empty string bc notch
-	
-	switch (type) {
-	case NBTtagType::Boolean:	size += sizeof(bool);		break;
-	case NBTtagType::Byte:		size += sizeof(int8_t);		break;
-	case NBTtagType::Short:		size += sizeof(int16_t);	break;
-	case NBTtagType::Int:		size += sizeof(int32_t);	break;
-	case NBTtagType::Long:		size += sizeof(int64_t);	break;
-	case NBTtagType::Float:		size += sizeof(float);		break;
-	case NBTtagType::Double:	size += sizeof(double);		break;
-	case NBTtagType::String:	size += sizeof(int16_t) + data.String->length() * sizeof(char);		break;
-	case NBTtagType::ByteArray:	size += sizeof(int32_t) + data.ByteArray->size() * sizeof(int8_t);	break;
-	case NBTtagType::IntArray:	size += sizeof(int32_t) + data.IntArray->size() * sizeof(int32_t);	break;
-	case NBTtagType::LongArray:	size += sizeof(int32_t) + data.LongArray->size() * sizeof(int64_t);	break;
-	case NBTtagType::List:
-		size += sizeof(uint32_t) + (sizeof(NBTtagType) + sizeof(uint16_t)) * data.List->size();
-		for (const auto& element : *data.List) {
-			size += element.size(false);
-		}
-		size += sizeof(NBTtagType::end);
-		break;
-	case NBTtagType::Compound:
-		for (const auto& element : *data.Compound) {
-			size += sizeof(NBTtagType) + sizeof(uint16_t) + element.first.length();
-			size += element.second.size(false);
+	} else if (type == NBTtagType::List) {
+		NBTtagType contentType; is >> contentType;
+		uint32_t length; is >> length;
+		NBTlist list(length);
+
+		if (contentType == NBTtagType::Compound) {
+			// paths through a list apply to every element, which always have to be read completely
+			for (uint32_t i = 0; i < length; i++) {
+				size_t elementPending = SIZE_MAX;
+				list[i] = parseFilteredCompound(is, filter, elementPending, keepRest);
+			}
+		} else if (static_cast<int8_t>(contentType) > 0) {
+			const auto& parser = getParser(contentType);
+			for (uint32_t i = 0; i < length; i++) {
+				list[i] = parser(is);
+			}
 		}
-		size += sizeof(NBTtagType::end);
+
+		pending -= filter.numLeaves;
+		return std::move(list);
 	}
-	return size;
+
+	pending -= filter.numLeaves;
+	return getParser(type)(is);
 }
 
-size_t NBT::length() {
-	switch (type) {
-	case NBTtagType::ByteArray:	return data.ByteArray->size();
-	case NBTtagType::IntArray:	return data.IntArray->size();
-	case NBTtagType::LongArray:	return data.LongArray->size();
-	case NBTtagType::List:		return data.List->size();
-	case NBTtagType::Compound:	return data.Compound->size();
-	default: throw std::bad_cast();
+NBT NBT::parseFilteredCompound(BEreader& is, const NBTfilter& filter, size_t& pending, bool keepRest) {
+	NBTcompound compound;
+	NBTtagType type;
+	std::string buffer;
+	while (pending > 0 && (is >> type, type) != NBTtagType::end) {
+		is >> buffer;
+		const InternedString name = buffer;
+
+		const NBTfilter* child = filter.find(name);
+		if (child == nullptr) {
+			if (keepRest) {
+				NBTraw raw{ type, {} };
+				skip(is, type, &raw.payload);
+				compound.insert({ name, std::move(raw) });
+			} else {
+				skip(is, type);
+			}
+		} else if (child->whole) {
+			compound.insert({ name, getParser(type)(is) });
+			pending--;
+		} else {
+			compound.insert({ name, parseFiltered(is, type, *child, pending, keepRest) });
+		}
 	}
+	return std::move(compound);
 }
 
+// skips 'length' bytes or appends them to 'capture'
+static void pass(BEreader& is, size_t length, std::vector<uint8_t>* capture) {
+	if (capture) {
+		const size_t offset = capture->size();
+		capture->resize(offset + length);
+		is.read(&(*capture)[offset], length);
+	} else {
+		is.skip(length);
+	}
+}
 
-//--------------/ serialization /--------------//
-
-uint8_t* NBT::serialize(size_t& size) const {
-	size = this->size();
-	uint8_t* bytes = new uint8_t[size];
-	BEstream os(bytes, size);
-
-	uint16_t emptyName = 0;
-	os << this->type << emptyName;
-
-	this->serialize(os);
-	return bytes;
+template<typename T>
+static T passValue(BEreader& is, std::vector<uint8_t>* capture) {
+	T value;
+	is >> value;
+	if (capture) {
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		for (size_t i = sizeof(T); i > 0; capture->push_back(bytes[--i]));
+	}
+	return value;
 }
 
-void NBT::serialize(BEstream& os) const {
+void NBT::skip(BEreader& is, NBTtagType type, std::vector<uint8_t>* capture) {
 	switch (type) {
-	case NBTtagType::Boolean:
-		os.buffer[os.index++] = static_cast<uint8_t>(data.Boolean);	break;
 	case NBTtagType::Byte:
-		os.buffer[os.index++] = static_cast<uint8_t>(data.Byte);	break;
-	case NBTtagType::Short:
-		os << data.Short;	break;
-	case NBTtagType::Int:
-		os << data.Int;		break;
-	case NBTtagType::Long:
-		os << data.Long;	break;
-	case NBTtagType::Float:
-		os << data.Float;	break;
-	case NBTtagType::Double:
-		os << data.Double;	break;
+	case NBTtagType::Boolean:	pass(is, sizeof(int8_t), capture);	break;
+	case NBTtagType::Short:		pass(is, sizeof(int16_t), capture);	break;
+	case NBTtagType::Int:		pass(is, sizeof(int32_t), capture);	break;
+	case NBTtagType::Long:		pass(is, sizeof(int64_t), capture);	break;
+	case NBTtagType::Float:		pass(is, sizeof(float), capture);	break;
+	case NBTtagType::Double:	pass(is, sizeof(double), capture);	break;
 	case NBTtagType::String:
-		os << *data.String;	break;
+		pass(is, passValue<uint16_t>(is, capture), capture);
+		break;
 	case NBTtagType::ByteArray:
-		os << static_cast<int32_t>(data.ByteArray->size());
-		for (const int8_t num : *data.ByteArray) os << num;
+		pass(is, passValue<uint32_t>(is, capture) * sizeof(int8_t), capture);
 		break;
 	case NBTtagType::IntArray:
-		os << static_cast<int32_t>(data.IntArray->size());
-		for (const int32_t num : *data.IntArray) os << num;
+		pass(is, passValue<uint32_t>(is, capture) * sizeof(int32_t), capture);
 		break;
 	case NBTtagType::LongArray:
-		os << static_cast<int32_t>(data.LongArray->size());
-		for (const int64_t num : *data.LongArray) os << num;
-		break;
-	case NBTtagType::List:
-		os << (data.List->size() > 0 ? data.List->at(0).type : NBTtagType::end);
-		os << static_cast<int32_t>(data.List->size());
-		for (const auto& nbt : *data.List) {
-			nbt.serialize(os);
-		}
+		pass(is, passValue<uint32_t>(is, capture) * sizeof(int64_t), capture);
 		break;
-	case NBTtagType::Compound:
-		for (const auto& element : *data.Compound) {
-			os << element.second.type << element.first;
-			element.second.serialize(os);
-		}
-		os << NBTtagType::end;
-	}
-}
-
-
-//--------------/ string/JSON conversion /--------------//
-
-template<typename T>
-void arrayToString(std::ostream& out, const std::vector<T>* array, int indent = -1) {
-	const std::string indentTabs = (indent < 0 ? "" : std::string(indent, '\t'));
-	const std::string lineBreak = (indent < 0 ? "" : "\n");
-
-	out << '[' << lineBreak;
-	const auto last = std::prev(array->end());
-	for(auto it = array->begin(); it != array->end(); it++) {
-		out << indentTabs << std::to_string(*it);
-		if (it == last) {
-			out << lineBreak;
-			break;
-		}
-		out << ',' << lineBreak;
-	}
-	out << (indent < 0 ? "" : std::string(--indent, '\t')) << ']';
-}
-
-
-void NBT::toString(std::stringstream& out, int indent) const {
-
-	const std::string indentTabs = (indent < 0 ? "" : std::string(++indent, tab));
-	const std::string lineBreak = (indent < 0 ? "" : "\n");
-
-	switch (type) {
-	case NBTtagType::Boolean:	out << (data.Boolean ? "true" : "false");  break;
-	case NBTtagType::Byte:		out << std::to_string(data.Byte);	break;
-	case NBTtagType::Short:		out << std::to_string(data.Short);	break;
-	case NBTtagType::Int:		out << std::to_string(data.Int);	break;
-	case NBTtagType::Long:		out << std::to_string(data.Long);	break;
-	case NBTtagType::Float:		out << std::to_string(data.Float);	break;
-	case NBTtagType::Double:	out << std::to_string(data.Double);	break;
-	case NBTtagType::String:	out << '\"'  << *data.String << '\"';  break;
-	case NBTtagType::ByteArray:	arrayToString(out, data.ByteArray, indent);	break;
-	case NBTtagType::IntArray:	arrayToString(out, data.IntArray, indent);	break;
-	case NBTtagType::LongArray:	arrayToString(out, data.LongArray, indent);	break;
 	case NBTtagType::List: {
-		out << '[' << lineBreak;
-		const auto last = std::prev(data.List->end());
-		for (auto it = data.List->begin(); it != data.List->end(); it++) {
-			out << indentTabs;
-			it->toString(out, indent);
-			if (it == last) {
-				out << lineBreak;
-				break;
+		const NBTtagType contentType = passValue<NBTtagType>(is, capture);
+		const uint32_t length = passValue<uint32_t>(is, capture);
+		if (static_cast<int8_t>(contentType) > 0) {
+			for (uint32_t i = 0; i < length; i++) {
+				skip(is, contentType, capture);
 			}
-			out << ',' << lineBreak;
 		}
-		out << (indent < 0 ? "" : std::string(--indent, tab)) << ']';
 		break;
 	}
 	case NBTtagType::Compound: {
-		out << '{' << lineBreak;
-		const auto last = std::prev(data.Compound->end());
-		for(auto it = data.Compound->begin(); it != data.Compound->end(); it++) {
-			out << indentTabs << '\"' << it->first << "\": ";
-			it->second.toString(out, indent);
-			if (it == last) {
-				out << lineBreak;
-				break;
-			}
-			out << ',' << lineBreak;
+		NBTtagType elementType;
+		while ((elementType = passValue<NBTtagType>(is, capture)) != NBTtagType::end) {
+			pass(is, passValue<uint16_t>(is, capture), capture);
+			skip(is, elementType, capture);
 		}
-		out << (indent < 0 ? "" : std::string(--indent, tab)) << '}';
 		break;
 	}
-	default: out << std::string("null");
-	}
-}
-
-
-//--------------/ cast operators /--------------//
-
-NBT::operator bool() const {
-	if (type == NBTtagType::Boolean)
-		return data.Boolean;
-	else throw std::bad_cast();
-}
-
-NBT::operator int8_t() const {
-	switch (type) {
-	case  NBTtagType::Byte:		return data.Byte;
-	case  NBTtagType::Short:	return static_cast<int8_t>(data.Short);
-	case  NBTtagType::Int:		return static_cast<int8_t>(data.Int);
-	case  NBTtagType::Long:		return static_cast<int8_t>(data.Long);
-	case  NBTtagType::Float:	return static_cast<int8_t>(data.Float);
-	case  NBTtagType::Double:	return static_cast<int8_t>(data.Double);
-	default: throw std::bad_cast();
-	}
-}
-
-NBT::operator int16_t() const {
-	switch (type) {
-	case  NBTtagType::Short:	return data.Short;
-	case  NBTtagType::Byte:		return static_cast<int16_t>(data.Byte);
-	case  NBTtagType::Int:		return static_cast<int16_t>(data.Int);
-	case  NBTtagType::Long:		return static_cast<int16_t>(data.Long);
-	case  NBTtagType::Float:	return static_cast<int16_t>(data.Float);
-	case  NBTtagType::Double:	return static_cast<int16_t>(data.Double);
-	default: throw std::bad_cast();
-	}
-}
-
-NBT::operator int32_t() const {
-	switch (type) {
-	case  NBTtagType::Int:		return data.Int;
-	case  NBTtagType::Long:		return static_cast<int32_t>(data.Long);
-	case  NBTtagType::Short:	return static_cast<int32_t>(data.Short);
-	case  NBTtagType::Byte:		return static_cast<int32_t>(data.Byte);
-	case  NBTtagType::Double:	return static_cast<int32_t>(data.Double);
-	case  NBTtagType::Float:	return static_cast<int32_t>(data.Float);
-	default: throw std::bad_cast();
+	default: throw std::runtime_error(std::string("Cannot skip NBT type ") + typeToString(type));
 	}
 }
 
-NBT::operator int64_t() const {
-	switch (type) {
-	case  NBTtagType::Long:		return data.Long;
-	case  NBTtagType::Int:		return static_cast<int64_t>(data.Int);
-	case  NBTtagType::Short:	return static_cast<int64_t>(data.Short);
-	case  NBTtagType::Byte:		return static_cast<int64_t>(data.Byte);
-	case  NBTtagType::Double:	return static_cast<int64_t>(data.Double);
-	case  NBTtagType::Float:	return static_cast<int64_t>(data.Float);
-	default: throw std::bad_cast();
-	}
-}
+void NBT::decodeRaw() const {
+	const NBTraw& raw = std::get<NBTraw>(value);
+	BEbufferReader is(raw.payload.data(), raw.payload.size());
+	NBT decoded = getParser(raw.type)(is);
 
-NBT::operator float() const {
-	switch (type) {
-	case  NBTtagType::Float:	return data.Float;
-	case  NBTtagType::Double:	return static_cast<float>(data.Double);
-	case  NBTtagType::Int:		return static_cast<float>(data.Int);
-	case  NBTtagType::Long:		return static_cast<float>(data.Long);
-	case  NBTtagType::Short:	return static_cast<float>(data.Short);
-	case  NBTtagType::Byte:		return static_cast<float>(data.Byte);
-	default: throw std::bad_cast();
-	}
+	value = std::move(decoded.value);
 }
 
-NBT::operator double() const {
-	switch (type) {
-	case  NBTtagType::Double:	return data.Double;
-	case  NBTtagType::Float:	return static_cast<double>(data.Float);
-	case  NBTtagType::Long:		return static_cast<double>(data.Long);
-	case  NBTtagType::Int:		return static_cast<double>(data.Int);
-	case  NBTtagType::Short:	return static_cast<double>(data.Short);
-	case  NBTtagType::Byte:		return static_cast<double>(data.Byte);
-	default: throw std::bad_cast();
-	}
+NBTtagType NBT::encodedType() const {
+	const NBTraw* raw = std::get_if<NBTraw>(&value);
+	return raw ? raw->type : getType();
 }
 
 
-NBT::operator const NBTstring&() const {
-	if (type == NBTtagType::String)
-		return *data.String;
-	throw std::bad_cast();
-}
-
-NBT::operator const NBTbyteArray&() const {
-	if (type == NBTtagType::ByteArray)
-		return *data.ByteArray;
-	throw std::bad_cast();
-}
+//--------------/ length /--------------//
 
-NBT::operator const NBTintArray&() const {
-	if (type == NBTtagType::IntArray)
-		return *data.IntArray;
-	throw std::bad_cast();
+size_t NBT::length() {
+	decode();
+	return std::visit(overloaded{
+		[](const NBTbyteArray& v) { return v.size(); },
+		[](const NBTintArray& v) { return v.size(); },
+		[](const NBTlongArray& v) { return v.size(); },
+		[](const NBTlist& v) { return v.size(); },
+		[](const NBTcompoundBox& v) { return v.get()->size(); },
+		[](const auto&) -> size_t { throw std::bad_cast(); }
+	}, value);
 }
 
-NBT::operator const NBTlongArray&() const {
-	if (type == NBTtagType::LongArray)
-		return *data.LongArray;
-	throw std::bad_cast();
-}
 
-NBT::operator const NBTlist&() const {
-	if (type == NBTtagType::List)
-		return *data.List;
-	throw std::bad_cast();
-}
+//--------------/ serialization /--------------//
 
-NBT::operator const NBTcompound&() const {
-	if (type == NBTtagType::Compound)
-		return *data.Compound;
-	throw std::bad_cast();
+uint8_t* NBT::serialize(size_t& size) const {
+	BEbufferWriter os;
+	serialize(os);
+	return os.release(size);
 }
 
-
-NBT::operator bool&() {
-	if (type == NBTtagType::Boolean)
-		return data.Boolean;
-	throw std::bad_cast();
+void NBT::serialize(BEwriter& os) const {
+	uint16_t emptyName = 0;
+	os << this->encodedType() << emptyName;
+
+	this->serializePayload(os);
+}
+
+void NBT::serializePayload(BEwriter& os) const {
+	std::visit(overloaded{
+		[](std::monostate) {},
+		[&os](bool b) {
+			os << static_cast<uint8_t>(b);
+		},
+		[&os](const NBTstring& s) {
+			os << s;
+		},
+		[&os](const NBTbyteArray& v) {
+			os << static_cast<int32_t>(v.size());
+			os.write(reinterpret_cast<const uint8_t*>(v.data()), v.size());
+		},
+		[&os](const NBTintArray& v) {
+			os << static_cast<int32_t>(v.size());
+			for (const int32_t num : v) os << num;
+		},
+		[&os](const NBTlongArray& v) {
+			os << static_cast<int32_t>(v.size());
+			for (const int64_t num : v) os << num;
+		},
+		[&os](const NBTlist& list) {
+			os << (list.size() > 0 ? list[0].encodedType() : NBTtagType::end);
+			os << static_cast<int32_t>(list.size());
+			for (const auto& nbt : list) {
+				nbt.serializePayload(os);
+			}
+		},
+		[&os](const NBTcompoundBox& box) {
+			for (const auto& element : *box.get()) {
+				os << element.second.encodedType() << element.first.string();
+				element.second.serializePayload(os);
+			}
+			os << NBTtagType::end;
+		},
+		[&os](const NBTraw& raw) {
+			os.write(raw.payload.data(), raw.payload.size());
+		},
+		[&os](auto num) {
+			os << num;
+		}
+	}, value);
 }
 
-NBT::operator int8_t&() {
-	if (type == NBTtagType::Byte)
-		return data.Byte;
-	throw std::bad_cast();
-}
 
-NBT::operator int16_t&() {
-	if (type == NBTtagType::Short)
-		return data.Short;
-	throw std::bad_cast();
-}
+//--------------/ string/JSON conversion /--------------//
 
-NBT::operator int32_t&() {
-	if (type == NBTtagType::Int)
-		return data.Int;
-	throw std::bad_cast();
-}
+template<typename T>
+void arrayToString(std::ostream& out, const std::vector<T>& array, int indent = -1) {
+	const std::string indentTabs = (indent < 0 ? "" : std::string(indent, '\t'));
+	const std::string lineBreak = (indent < 0 ? "" : "\n");
 
-NBT::operator int64_t&() {
-	if (type == NBTtagType::Long)
-		return data.Long;
-	throw std::bad_cast();
+	out << '[' << lineBreak;
+	for (size_t i = 0; i < array.size(); i++) {
+		out << (i > 0 ? "," + lineBreak : "") << indentTabs << std::to_string(array[i]);
+	}
+	out << (array.empty() ? "" : lineBreak);
+	out << (indent < 0 ? "" : std::string(--indent, '\t')) << ']';
 }
 
-NBT::operator float&() {
-	if (type == NBTtagType::Float)
-		return data.Float;
-	throw std::bad_cast();
-}
 
-NBT::operator double&() {
-	if (type == NBTtagType::Double)
-		return data.Double;
-	throw std::bad_cast();
-}
+void NBT::toString(std::stringstream& out, int indent) const {
+	decode();
 
-NBT::operator NBTstring&() {
-	if (type == NBTtagType::String)
-		return *data.String;
-	throw std::bad_cast();
-}
+	const std::string indentTabs = (indent < 0 ? "" : std::string(++indent, tab));
+	const std::string lineBreak = (indent < 0 ? "" : "\n");
 
-NBT::operator NBTbyteArray&() {
-	if (type == NBTtagType::ByteArray)
-		return *data.ByteArray;
-	throw std::bad_cast();
+	std::visit(overloaded{
+		[&](std::monostate) { out << "null"; },
+		[&](bool b) { out << (b ? "true" : "false"); },
+		[&](const NBTstring& s) { out << '\"' << s << '\"'; },
+		[&](const NBTbyteArray& v) { arrayToString(out, v, indent); },
+		[&](const NBTintArray& v) { arrayToString(out, v, indent); },
+		[&](const NBTlongArray& v) { arrayToString(out, v, indent); },
+		[&](const NBTlist& list) {
+			out << '[' << lineBreak;
+			for (size_t i = 0; i < list.size(); i++) {
+				out << (i > 0 ? "," + lineBreak : "") << indentTabs;
+				list[i].toString(out, indent);
+			}
+			out << (list.empty() ? "" : lineBreak);
+			out << (indent < 0 ? "" : std::string(indent - 1, tab)) << ']';
+		},
+		[&](const NBTcompoundBox& box) {
+			out << '{' << lineBreak;
+			bool first = true;
+			for (const auto& element : *box.get()) {
+				out << (first ? "" : "," + lineBreak) << indentTabs << '\"' << element.first.string() << "\": ";
+				element.second.toString(out, indent);
+				first = false;
+			}
+			out << (first ? "" : lineBreak);
+			out << (indent < 0 ? "" : std::string(indent - 1, tab)) << '}';
+		},
+		[&](const NBTraw&) {},
+		[&](auto num) { out << std::to_string(num); }
+	}, value);
 }
 
-NBT::operator NBTintArray&() {
-	if (type == NBTtagType::IntArray)
-		return *data.IntArray;
-	throw std::bad_cast();
-}
 
-NBT::operator NBTlongArray&() {
-	if (type == NBTtagType::LongArray)
-		return *data.LongArray;
-	throw std::bad_cast();
-}
+//--------------/ cast operators /--------------//
 
-NBT::operator NBTlist&() {
-	if (type == NBTtagType::List)
-		return *data.List;
+template<typename T>
+T& NBT::as() const {
+	if (T* ptr = const_cast<NBT*>(this)->try_get<T>())
+		return *ptr;
 	throw std::bad_cast();
 }
 
-NBT::operator NBTcompound&() {
-	if (type == NBTtagType::Compound)
-		return *data.Compound;
-	throw std::bad_cast();
-}
+// converts between all numeric types except bool
+template<typename T>
+T NBT::number() const {
+	decode();
+	return std::visit([](const auto& v) -> T {
+		using V = std::decay_t<decltype(v)>;
+		if constexpr (std::is_arithmetic_v<V> && !std::is_same_v<V, bool>) {
+			return static_cast<T>(v);
+		} else {
+			throw std::bad_cast();
+		}
+	}, value);
+}
+
+NBT::operator bool() const				{ return as<bool>(); }
+NBT::operator int8_t() const			{ return number<int8_t>(); }
+NBT::operator int16_t() const			{ return number<int16_t>(); }
+NBT::operator int32_t() const			{ return number<int32_t>(); }
+NBT::operator int64_t() const			{ return number<int64_t>(); }
+NBT::operator float() const				{ return number<float>(); }
+NBT::operator double() const			{ return number<double>(); }
+
+NBT::operator const NBTstring&() const		{ return as<NBTstring>(); }
+NBT::operator const NBTbyteArray&() const	{ return as<NBTbyteArray>(); }
+NBT::operator const NBTintArray&() const	{ return as<NBTintArray>(); }
+NBT::operator const NBTlongArray&() const	{ return as<NBTlongArray>(); }
+NBT::operator const NBTlist&() const		{ return as<NBTlist>(); }
+NBT::operator const NBTcompound&() const	{ return as<NBTcompound>(); }
+
+NBT::operator bool&()				{ return as<bool>(); }
+NBT::operator int8_t&()				{ return as<int8_t>(); }
+NBT::operator int16_t&()			{ return as<int16_t>(); }
+NBT::operator int32_t&()			{ return as<int32_t>(); }
+NBT::operator int64_t&()			{ return as<int64_t>(); }
+NBT::operator float&()				{ return as<float>(); }
+NBT::operator double&()				{ return as<double>(); }
+
+NBT::operator NBTstring&()			{ return as<NBTstring>(); }
+NBT::operator NBTbyteArray&()		{ return as<NBTbyteArray>(); }
+NBT::operator NBTintArray&()		{ return as<NBTintArray>(); }
+NBT::operator NBTlongArray&()		{ return as<NBTlongArray>(); }
+NBT::operator NBTlist&()			{ return as<NBTlist>(); }
+NBT::operator NBTcompound&()		{ return as<NBTcompound>(); }
 
 
 //--------------/ assignment operators /--------------//
 
-NBT& NBT::operator=(bool b) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::Boolean;
-	} else if (type != NBTtagType::Boolean) {
-		throw std::bad_cast();
-	}
-	data.Boolean = b;
-	return *this;
-}
-
-NBT& NBT::operator=(int8_t i) {
-	switch (type) {
-	case NBTtagType::null:		type = NBTtagType::Byte;
-	case NBTtagType::Byte:		data.Byte	= i; break;
-	case NBTtagType::Short:		data.Short	= static_cast<int16_t>(i); break;
-	case NBTtagType::Int:		data.Int	= static_cast<int32_t>(i); break;
-	case NBTtagType::Long:		data.Long	= static_cast<int64_t>(i); break;
-	case NBTtagType::Float:		data.Float	= static_cast<float>(i); break;
-	case NBTtagType::Double:	data.Double	= static_cast<double>(i); break;
-	default: throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(int16_t i) {
-	switch (type) {
-	case NBTtagType::null:		type = NBTtagType::Short;
-	case NBTtagType::Short:		data.Short	= i; break;
-	case NBTtagType::Byte:		data.Byte	= static_cast<int8_t>(i); break;
-	case NBTtagType::Int:		data.Int	= static_cast<int32_t>(i); break;
-	case NBTtagType::Long:		data.Long	= static_cast<int64_t>(i); break;
-	case NBTtagType::Float:		data.Float	= static_cast<float>(i); break;
-	case NBTtagType::Double:	data.Double	= static_cast<double>(i); break;
-	default: throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(int32_t i) {
-	switch (type) {
-	case NBTtagType::null:		type = NBTtagType::Int;
-	case NBTtagType::Int:		data.Int	= i; break;
-	case NBTtagType::Long:		data.Long	= static_cast<int64_t>(i); break;
-	case NBTtagType::Short:		data.Short	= static_cast<int16_t>(i); break;
-	case NBTtagType::Byte:		data.Byte	= static_cast<int8_t>(i); break;
-	case NBTtagType::Float:		data.Float	= static_cast<float>(i); break;
-	case NBTtagType::Double:	data.Double	= static_cast<double>(i); break;
-	default: throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(int64_t i) {
-	switch (type) {
-	case NBTtagType::null:		type = NBTtagType::Long;
-	case NBTtagType::Long:		data.Long	= i; break;
-	case NBTtagType::Int:		data.Int	= static_cast<int32_t>(i); break;
-	case NBTtagType::Short:		data.Short	= static_cast<int16_t>(i); break;
-	case NBTtagType::Byte:		data.Byte	= static_cast<int8_t>(i); break;
-	case NBTtagType::Float:		data.Float	= static_cast<float>(i); break;
-	case NBTtagType::Double:	data.Double	= static_cast<double>(i); break;
-	default: throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(float f) {
-	switch (type) {
-	case NBTtagType::null:		type = NBTtagType::Float;
-	case NBTtagType::Float:		data.Float	= f; break;
-	case NBTtagType::Double:	data.Double	= static_cast<double>(f); break;
-	case NBTtagType::Byte:		data.Byte	= static_cast<int8_t>(f); break;
-	case NBTtagType::Short:		data.Short	= static_cast<int16_t>(f); break;
-	case NBTtagType::Int:		data.Int	= static_cast<int32_t>(f); break;
-	case NBTtagType::Long:		data.Long	= static_cast<int64_t>(f); break;
-	default: throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(double d) {
-	switch (type) {
-	case NBTtagType::null:		type = NBTtagType::Double;
-	case NBTtagType::Double:	data.Double = d; break;
-	case NBTtagType::Float:		data.Float	= static_cast<float>(d); break;
-	case NBTtagType::Byte:		data.Byte	= static_cast<int8_t>(d); break;
-	case NBTtagType::Short:		data.Short	= static_cast<int16_t>(d); break;
-	case NBTtagType::Int:		data.Int	= static_cast<int32_t>(d); break;
-	case NBTtagType::Long:		data.Long	= static_cast<int64_t>(d); break;
-	default: throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(const NBTstring& s) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::String;
-		data.String = new NBTstring(s);
-	} else if (type == NBTtagType::String) {
-		*data.String = s;
-	} else {
-		throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(const NBTbyteArray& v) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::ByteArray;
-		data.ByteArray = new NBTbyteArray(v);
-	} else if (type == NBTtagType::ByteArray) {
-		*data.ByteArray = v;
-	} else {
-		throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(const NBTintArray& v) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::IntArray;
-		data.IntArray = new NBTintArray(v);
-	} else if (type == NBTtagType::IntArray) {
-		*data.IntArray = v;
-	} else {
-		throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(const NBTlongArray& v) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::LongArray;
-		data.LongArray = new NBTlongArray(v);
-	} else if (type == NBTtagType::LongArray) {
-		*data.LongArray = v;
-	} else {
-		throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(const NBTlist& v) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::List;
-		data.List = new NBTlist(v);
-	} else if (type == NBTtagType::List) {
-		*data.List = v;
-	} else {
-		throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(const NBTcompound& m) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::Compound;
-		data.Compound = new NBTcompound(m);
-	} else if (type == NBTtagType::Compound) {
-		*data.Compound = m;
-	} else {
-		throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(NBTstring&& s) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::String;
-		data.String = new NBTstring(std::move(s));
-	} else if (type == NBTtagType::String) {
-		*data.String = std::move(s);
-	} else {
-		throw std::bad_cast();
-	}
-	return *this;
-}
-
-NBT& NBT::operator=(NBTbyteArray&& v) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::ByteArray;
-		data.ByteArray = new NBTbyteArray(std::move(v));
-	} else if (type == NBTtagType::ByteArray) {
-		*data.ByteArray = std::move(v);
+// a null tag takes the type of 'n', numeric tags keep their type
+template<typename T>
+NBT& NBT::assignNumber(T n) {
+	decode();
+	if (std::holds_alternative<std::monostate>(value)) {
+		value.emplace<T>(n);
 	} else {
-		throw std::bad_cast();
+		std::visit([n](auto& v) {
+			using V = std::decay_t<decltype(v)>;
+			if constexpr (std::is_arithmetic_v<V> && !std::is_same_v<V, bool>) {
+				v = static_cast<V>(n);
+			} else {
+				throw std::bad_cast();
+			}
+		}, value);
 	}
 	return *this;
 }
 
-NBT& NBT::operator=(NBTintArray&& v) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::IntArray;
-		data.IntArray = new NBTintArray(std::move(v));
-	} else if (type == NBTtagType::IntArray) {
-		*data.IntArray = std::move(v);
+// a null tag takes the type of 'v', other tags have to match it
+template<typename T>
+NBT& NBT::assignValue(T&& v) {
+	using V = std::decay_t<T>;
+	decode();
+	if (std::holds_alternative<std::monostate>(value)) {
+		if constexpr (std::is_same_v<V, NBTcompound>) {
+			value.emplace<NBTcompoundBox>(std::forward<T>(v));
+		} else {
+			value.emplace<V>(std::forward<T>(v));
+		}
+	} else if (V* ptr = try_get<V>()) {
+		*ptr = std::forward<T>(v);
 	} else {
 		throw std::bad_cast();
 	}
 	return *this;
 }
 
-NBT& NBT::operator=(NBTlongArray&& v) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::LongArray;
-		data.LongArray = new NBTlongArray(std::move(v));
-	} else if (type == NBTtagType::LongArray) {
-		*data.LongArray = std::move(v);
+NBT& NBT::operator=(bool b) {
+	decode();
+	if (std::holds_alternative<std::monostate>(value)) {
+		value.emplace<bool>(b);
 	} else {
-		throw std::bad_cast();
+		as<bool>() = b;
 	}
 	return *this;
 }
 
-NBT& NBT::operator=(NBTlist&& v) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::List;
-		data.List = new NBTlist(std::move(v));
-	} else if (type == NBTtagType::List) {
-		*data.List = std::move(v);
-	} else {
-		throw std::bad_cast();
-	}
-	return *this;
-}
+NBT& NBT::operator=(int8_t i)		{ return assignNumber(i); }
+NBT& NBT::operator=(int16_t i)		{ return assignNumber(i); }
+NBT& NBT::operator=(int32_t i)		{ return assignNumber(i); }
+NBT& NBT::operator=(int64_t i)		{ return assignNumber(i); }
+NBT& NBT::operator=(float f)		{ return assignNumber(f); }
+NBT& NBT::operator=(double d)		{ return assignNumber(d); }
 
+NBT& NBT::operator=(const NBTstring& s)		{ return assignValue(s); }
+NBT& NBT::operator=(const NBTbyteArray& v)	{ return assignValue(v); }
+NBT& NBT::operator=(const NBTintArray& v)	{ return assignValue(v); }
+NBT& NBT::operator=(const NBTlongArray& v)	{ return assignValue(v); }
+NBT& NBT::operator=(const NBTlist& v)		{ return assignValue(v); }
+NBT& NBT::operator=(const NBTcompound& m)	{ return assignValue(m); }
 
-NBT& NBT::operator=(NBTcompound&& m) {
-	if (type == NBTtagType::null) {
-		type = NBTtagType::Compound;
-		data.Compound = new NBTcompound(std::move(m));
-	} else if (type == NBTtagType::Compound) {
-		*data.Compound = std::move(m);
-	} else {
-		throw std::bad_cast();
-	}
-	return *this;
-}
+NBT& NBT::operator=(NBTstring&& s)			{ return assignValue(std::move(s)); }
+NBT& NBT::operator=(NBTbyteArray&& v)		{ return assignValue(std::move(v)); }
+NBT& NBT::operator=(NBTintArray&& v)		{ return assignValue(std::move(v)); }
+NBT& NBT::operator=(NBTlongArray&& v)		{ return assignValue(std::move(v)); }
+NBT& NBT::operator=(NBTlist&& v)			{ return assignValue(std::move(v)); }
+NBT& NBT::operator=(NBTcompound&& m)		{ return assignValue(std::move(m)); }
 
 NBT& NBT::operator=(const NBT& nbt) {
-
-	if (type == NBTtagType::null) {
-		switch (type) {
-		case NBTtagType::String:	data.String		= new NBTstring(*nbt.data.String);			break;
-		case NBTtagType::ByteArray:	data.ByteArray	= new NBTbyteArray(*nbt.data.ByteArray);	break;
-		case NBTtagType::IntArray:	data.IntArray	= new NBTintArray(*nbt.data.IntArray);		break;
-		case NBTtagType::LongArray:	data.LongArray	= new NBTlongArray(*nbt.data.LongArray);	break;
-		case NBTtagType::List:		data.List		= new NBTlist(*nbt.data.List);				break;
-		case NBTtagType::Compound:	data.Compound	= new NBTcompound(*nbt.data.Compound);		break;
-		default: this->data = nbt.data;
-		}
-		this->type = nbt.type;
-	} else if (type == nbt.type) {
-		switch (type) {
-		case NBTtagType::String:	*data.String	= *nbt.data.String;		break;
-		case NBTtagType::ByteArray:	*data.ByteArray	= *nbt.data.ByteArray;	break;
-		case NBTtagType::IntArray:	*data.IntArray	= *nbt.data.IntArray;	break;
-		case NBTtagType::LongArray:	*data.LongArray	= *nbt.data.LongArray;	break;
-		case NBTtagType::List:		*data.List		= *nbt.data.List;		break;
-		case NBTtagType::Compound:	*data.Compound	= *nbt.data.Compound;	break;
-		default: this->data = nbt.data;
-		}
+	if (this != &nbt) {
+		value = nbt.value;
 	}
-
 	return *this;
 }
 
 NBT& NBT::operator=(NBT&& nbt) noexcept {
 	if (this != &nbt) {
-		cleanup();
-
-		this->data = nbt.data;
-		this->type = nbt.type;
-
-		nbt.type = NBTtagType::null;
-		nbt.data.String = nullptr;
+		value = std::move(nbt.value);
+		nbt.value.emplace<std::monostate>();
 	}
 	return *this;
 }
@@ -930,39 +732,40 @@ NBT& NBT::operator=(NBT&& nbt) noexcept {
 //--------------/ member access operators /--------------//
 
 NBT& NBT::operator[](const size_t index) {
-	if (type == NBTtagType::null) {
-		data.List = new NBTlist();
-		type = NBTtagType::List;
+	decode();
+	if (std::holds_alternative<std::monostate>(value)) {
+		value.emplace<NBTlist>();
 	}
-	if (type == NBTtagType::List) {
-		if (index == data.List->size()) {
-			return *data.List->insert(data.List->begin() + index, NBT());
+	if (NBTlist* list = try_get<NBTlist>()) {
+		if (index == list->size()) {
+			return list->emplace_back();
 		} else {
-			return data.List->at(index);
+			return list->at(index);
 		}
 	}
 	throw std::bad_cast();
 }
 
-NBT& NBT::operator[](const std::string& s) {
-	if (type == NBTtagType::null) {
-		data.Compound = new NBTcompound();
-		type = NBTtagType::Compound;
+NBT& NBT::operator[](const InternedString& key) {
+	decode();
+	if (std::holds_alternative<std::monostate>(value)) {
+		value.emplace<NBTcompoundBox>();
 	}
-	if (type == NBTtagType::Compound) {
-		return (*data.Compound)[s];
+	if (NBTcompound* compound = try_get<NBTcompound>()) {
+		return (*compound)[key];
 	}
-	else throw std::bad_cast();
+	throw std::bad_cast();
 }
 
+NBT* NBT::find(const InternedString& key) {
+	NBTcompound* compound = try_get<NBTcompound>();
+	if (!compound)
+		return nullptr;
 
-void NBT::cleanup() {
-	switch (type) {
-	case NBTtagType::String:	delete data.String;		data.String = nullptr;	break;
-	case NBTtagType::ByteArray:	delete data.ByteArray;	data.ByteArray = nullptr;	break;
-	case NBTtagType::IntArray:	delete data.IntArray;	data.IntArray = nullptr;	break;
-	case NBTtagType::LongArray:	delete data.LongArray;	data.LongArray = nullptr;	break;
-	case NBTtagType::List:		delete data.List;		data.List = nullptr;	break;
-	case NBTtagType::Compound:	delete data.Compound;	data.Compound = nullptr;	break;
-	}
+	auto it = compound->find(key);
+	return it == compound->end() ? nullptr : &it->second;
+}
+
+const NBT* NBT::find(const InternedString& key) const {
+	return const_cast<NBT*>(this)->find(key);
 }
@@ -34,7 +34,7 @@ OBJ OBJ::loadOBJ(std::string path) {
 	std::vector<indexTriangle> triangleList;
 
 	//add default material
-	materials.push_back(material{ "defaultMTL", { 0, 0, 0, 255 }, "minecraft:air", SIZE_MAX });
+	materials.push_back(material{ "defaultMTL", { 0, 0, 0, 255 }, BlockRegistry::id("minecraft:air"), SIZE_MAX });
 
 	bool foundMtlLib = false;
 	int32_t materialIndex = 0;
@@ -168,7 +168,7 @@ void OBJ::loadMTL(std::string filename, std::vector<material>& materials, std::v
 		} else if (line.rfind("d ", 0) == 0) {
 			m.c.a = static_cast<int>(255 * stof(line.substr(2)));
 		} else if (line.rfind("blockID ", 0) == 0) {
-			m.blockID = line.substr(8);
+			m.blockID = BlockRegistry::id(line.substr(8));
 		} else if (line.rfind("map_Kd ", 0) == 0) {
 			std::string imageName = line.substr(7);
 
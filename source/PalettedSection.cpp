@@ -0,0 +1,137 @@
+#include <PalettedSection.hpp>
+
+#include <BlockRegistry.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+
+PalettedSection::PalettedSection(const ChunkSections& _sections, const ChunkSections::Section& _section, uint16_t emptyBlock) :
+	sections{ _sections }, section{ _section } {
+
+	sections.unpack(section, indices);
+
+	NBTlist& palette = *section.palette;
+	if (palette.empty())
+		palette.push_back(NBTcompound{ { ChunkSchema::Name.key, BlockRegistry::name(emptyBlock).string() } });
+
+	index();
+
+	for (size_t i = 0; i < 4096; i++) {
+		if (indices[i] >= refCounts.size())
+			throw std::runtime_error("[section_error] palette index " + std::to_string(indices[i]) +
+				" is out of range for " + std::to_string(refCounts.size()) + " palette entries");
+		refCounts[indices[i]]++;
+	}
+}
+
+void PalettedSection::index() {
+	const NBTlist& palette = *section.palette;
+
+	refCounts.assign(palette.size(), 0);
+	blockIDs.resize(palette.size());
+	slots.assign(BlockRegistry::size(), UINT16_MAX);
+
+	// the first slot of a block wins, like a scan through the palette
+	for (size_t i = palette.size(); i-- > 0;) {
+		blockIDs[i] = BlockRegistry::id(ChunkSchema::Name.get(palette[i]));
+		if (blockIDs[i] >= slots.size())
+			slots.resize(static_cast<size_t>(blockIDs[i]) + 1, UINT16_MAX);
+		slots[blockIDs[i]] = static_cast<uint16_t>(i);
+	}
+}
+
+uint16_t PalettedSection::slotOf(uint16_t blockID) {
+	if (blockID >= slots.size())
+		slots.resize(static_cast<size_t>(blockID) + 1, UINT16_MAX);
+
+	uint16_t& slot = slots[blockID];
+	if (slot == UINT16_MAX) {
+		slot = static_cast<uint16_t>(blockIDs.size());
+		section.palette->push_back(NBTcompound{ { ChunkSchema::Name.key, BlockRegistry::name(blockID).string() } });
+		blockIDs.push_back(blockID);
+		refCounts.push_back(0);
+	}
+	return slot;
+}
+
+void PalettedSection::encode() {
+	NBTlist& palette = *section.palette;
+
+	//------------------------/ compact palette /------------------------//
+
+	if (hasUnusedSlots()) {
+		std::vector<uint16_t> remap(palette.size(), UINT16_MAX);
+		std::vector<uint32_t> counts;
+		NBTlist compacted;
+
+		for (size_t i = 0; i < palette.size(); i++) {
+			if (refCounts[i] > 0) {
+				remap[i] = static_cast<uint16_t>(compacted.size());
+				counts.push_back(refCounts[i]);
+				compacted.push_back(std::move(palette[i]));
+			}
+		}
+
+		for (size_t i = 0; i < 4096; i++)
+			indices[i] = remap[indices[i]];
+
+		palette = std::move(compacted);
+
+		index();
+		refCounts = std::move(counts);
+	}
+
+	//------------------------/ block states /------------------------//
+
+	sections.pack(section, indices);
+}
+
+bool PalettedSection::apply(ChunkSections& sections, int8_t y, const SectionPatch& patch, uint16_t emptyBlock) {
+	if (patch.empty())
+		return false;
+
+	ChunkSections::Section* found = sections.find(y);
+
+	// a missing section only holds the empty block, it is created once the patch writes something else
+	if (!found || !found->palette || found->palette->empty()) {
+		if (std::all_of(patch.blockIDs.begin(), patch.blockIDs.end(), [emptyBlock](uint16_t id) { return id == emptyBlock; }))
+			return false;
+	}
+
+	// also inserts the block states a section with a single entry palette may not have
+	found = &sections.getOrCreate(y);
+
+	// the use counts of the slots need every index, so the section is always decoded
+	PalettedSection paletted(sections, *found, emptyBlock);
+	const size_t paletteSize = paletted.paletteSize();
+
+	std::vector<uint16_t> positions, changedSlots;
+
+	for (size_t i = 0; i < patch.size(); i++) {
+		if (paletted.setBlock(patch.positions[i], patch.blockIDs[i])) {
+			positions.push_back(patch.positions[i]);
+			changedSlots.push_back(paletted.slot(patch.positions[i]));
+		}
+	}
+
+	if (positions.empty())
+		return false;
+
+	//------------------------/ patch block states /------------------------//
+
+	ChunkSections::Section& section = paletted.section;
+
+	if (paletted.paletteSize() == paletteSize && !paletted.hasUnusedSlots() &&
+		section.blockStates->size() == sections.getCodec().numLongs(paletteSize)) {
+
+		sections.set(section, positions.data(), changedSlots.data(), positions.size());
+		return true;
+	}
+
+	//------------------------/ re-encode /------------------------//
+
+	paletted.encode();
+	return true;
+}
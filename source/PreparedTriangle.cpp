@@ -0,0 +1,187 @@
+#include <PreparedTriangle.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+
+static const constexpr float voxelHalfsize = 0.5f;
+static const constexpr float brickHalfsize = 2.0f;
+
+// relative slack of the brick intervals, far above the rounding of a projection
+static const constexpr float brickSlack = 1e-5f;
+
+static float widenDown(float value, float by) {
+	return value - by - brickSlack * (1.0f + std::abs(value) + by);
+}
+
+static float widenUp(float value, float by) {
+	return value + by + brickSlack * (1.0f + std::abs(value) + by);
+}
+
+// covers the rounding of the voxel range, the separating axis test decides
+static const constexpr float voxelEpsilon = 1e-4f;
+
+PreparedTriangle::PreparedTriangle(const pointerTriangle& triangle) {
+	const vf3& first = *(triangle.vertices[0]);
+	anchor[0] = static_cast<int>(std::floor(first.x));
+	anchor[1] = static_cast<int>(std::floor(first.y));
+	anchor[2] = static_cast<int>(std::floor(first.z));
+
+	const vf3 offset(static_cast<float>(anchor[0]), static_cast<float>(anchor[1]), static_cast<float>(anchor[2]));
+
+	for (int i = 0; i < 3; i++) {
+		vertices[i] = *(triangle.vertices[i]) - offset;
+	}
+	m = triangle.m;
+
+	edges[0] = vertices[1] - vertices[0];
+	edges[1] = vertices[2] - vertices[1];
+	edges[2] = vertices[0] - vertices[2];
+
+	normal = edges[0].cross(edges[1]);
+	planeOffset = normal.dot(vertices[0]);
+
+	//------------------------/ bounds /------------------------//
+
+	min = vertices[0];
+	max = vertices[0];
+	for (int i = 1; i < 3; i++) {
+		min = vf3(std::min(min.x, vertices[i].x), std::min(min.y, vertices[i].y), std::min(min.z, vertices[i].z));
+		max = vf3(std::max(max.x, vertices[i].x), std::max(max.y, vertices[i].y), std::max(max.z, vertices[i].z));
+	}
+
+	for (int axis = 0; axis < 3; axis++) {
+		voxelMin[axis] = anchor[axis] + static_cast<int>(std::ceil((&min.x)[axis] - voxelEpsilon)) - 1;
+		voxelMax[axis] = anchor[axis] + static_cast<int>(std::floor((&max.x)[axis] + voxelEpsilon));
+	}
+
+	extentLower = min - vf3(voxelHalfsize, voxelHalfsize, voxelHalfsize);
+	extentUpper = max + vf3(voxelHalfsize, voxelHalfsize, voxelHalfsize);
+
+	brickExtentLower = vf3(widenDown(min.x, brickHalfsize), widenDown(min.y, brickHalfsize), widenDown(min.z, brickHalfsize));
+	brickExtentUpper = vf3(widenUp(max.x, brickHalfsize), widenUp(max.y, brickHalfsize), widenUp(max.z, brickHalfsize));
+
+	//------------------------/ separating axes /------------------------//
+
+	for (int edge = 0; edge < 3; edge++) {
+		const vf3& e = edges[edge];
+		for (int k = 0; k < 3; k++) {
+			const int i = (k + 1) % 3;
+			const int j = (k + 2) % 3;
+
+			Axis& axis = edgeAxes[edge * 3 + k];
+			axis.a = (&e.x)[j];
+			axis.b = (&e.x)[i];
+
+			float lower = INFINITY, upper = -INFINITY;
+			for (const vf3& v : vertices) {
+				const float p = axis.a * (&v.x)[i] - axis.b * (&v.x)[j];
+				lower = std::min(lower, p);
+				upper = std::max(upper, p);
+			}
+
+			const float extent = std::abs(axis.a) + std::abs(axis.b);
+			axis.lower = lower - voxelHalfsize * extent;
+			axis.upper = upper + voxelHalfsize * extent;
+			axis.brickLower = widenDown(lower, brickHalfsize * extent);
+			axis.brickUpper = widenUp(upper, brickHalfsize * extent);
+		}
+	}
+
+	const float normalExtent = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	planeLower = planeOffset - voxelHalfsize * normalExtent;
+	planeUpper = planeOffset + voxelHalfsize * normalExtent;
+	brickPlaneLower = widenDown(planeOffset, brickHalfsize * normalExtent);
+	brickPlaneUpper = widenUp(planeOffset, brickHalfsize * normalExtent);
+
+	//------------------------/ texture mapping /------------------------//
+
+	uGradient = vf3(0.0f, 0.0f, 0.0f);
+	vGradient = vf3(0.0f, 0.0f, 0.0f);
+	uOffset = vOffset = 0.0f;
+
+	if (!textured())
+		return;
+
+	// barycentric weights of p are v = (p - v0) . baryV and w = (p - v0) . baryW, folded into
+	// the texture coordinates of the vertices in double and stored as one float transform
+	const vd3 s(vertices[1] - vertices[0]);
+	const vd3 t(vertices[2] - vertices[0]);
+	const vd3 n = s.cross(t);
+	const double invDet = 1.0 / n.dot(n);
+
+	vd3 baryW = n.cross(s) * invDet;
+	vd3 baryV = t.cross(n) * invDet;
+
+	const vd2& uv0 = *(triangle.texCoords[0]);
+	const vd2& uv1 = *(triangle.texCoords[1]);
+	const vd2& uv2 = *(triangle.texCoords[2]);
+
+	const vd3 uGrad = baryV * (uv1.x - uv0.x) + baryW * (uv2.x - uv0.x);
+	const vd3 vGrad = baryV * (uv1.y - uv0.y) + baryW * (uv2.y - uv0.y);
+	const vd3 origin(vertices[0]);
+
+	uGradient = vf3(static_cast<float>(uGrad.x), static_cast<float>(uGrad.y), static_cast<float>(uGrad.z));
+	vGradient = vf3(static_cast<float>(vGrad.x), static_cast<float>(vGrad.y), static_cast<float>(vGrad.z));
+	uOffset = static_cast<float>(uv0.x - uGrad.dot(origin));
+	vOffset = static_cast<float>(uv0.y - vGrad.dot(origin));
+}
+
+bool PreparedTriangle::overlapsVoxel(const vf3& center) const {
+	if (center.x < extentLower.x || center.x > extentUpper.x ||
+		center.y < extentLower.y || center.y > extentUpper.y ||
+		center.z < extentLower.z || center.z > extentUpper.z)
+		return false;
+
+	for (int edge = 0; edge < 3; edge++) {
+		for (int k = 0; k < 3; k++) {
+			const Axis& axis = edgeAxes[edge * 3 + k];
+			const float q = axis.a * (&center.x)[(k + 1) % 3] - axis.b * (&center.x)[(k + 2) % 3];
+			if (q < axis.lower || q > axis.upper)
+				return false;
+		}
+	}
+
+	const float q = normal.x * center.x + normal.y * center.y + normal.z * center.z;
+	return q >= planeLower && q <= planeUpper;
+}
+
+bool PreparedTriangle::overlapsBrick(const vf3& center) const {
+	if (center.x < brickExtentLower.x || center.x > brickExtentUpper.x ||
+		center.y < brickExtentLower.y || center.y > brickExtentUpper.y ||
+		center.z < brickExtentLower.z || center.z > brickExtentUpper.z)
+		return false;
+
+	for (int edge = 0; edge < 3; edge++) {
+		for (int k = 0; k < 3; k++) {
+			const Axis& axis = edgeAxes[edge * 3 + k];
+			const float q = axis.a * (&center.x)[(k + 1) % 3] - axis.b * (&center.x)[(k + 2) % 3];
+			if (q < axis.brickLower || q > axis.brickUpper)
+				return false;
+		}
+	}
+
+	const float q = normal.x * center.x + normal.y * center.y + normal.z * center.z;
+	return q >= brickPlaneLower && q <= brickPlaneUpper;
+}
+
+std::vector<PreparedTriangle> PreparedTriangle::prepare(const std::vector<pointerTriangle>& triangles, uint32_t numThreads) {
+	numThreads = std::max(numThreads, 1U);
+
+	std::vector<PreparedTriangle> prepared(triangles.size());
+
+	const size_t chunkSize = (triangles.size() + numThreads - 1) / numThreads;
+	std::vector<std::thread> threads;
+	for (size_t begin = 0; begin < triangles.size(); begin += chunkSize) {
+		threads.emplace_back([&, begin]() {
+			const size_t end = std::min(begin + chunkSize, triangles.size());
+			for (size_t i = begin; i < end; i++)
+				prepared[i] = PreparedTriangle(triangles[i]);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	return prepared;
+}
@@ -7,7 +7,7 @@
 #include <Binary.hpp>
 
 void Region::loadMCAtoBuffer(const std::string& filename, int x, int z, const vf3& min, const vf3& max,
-	LockableQueue<Chunk> &inputBuffer, LockableQueue<Chunk> &outputBuffer) {
+	LockableQueue<Chunk> &inputBuffer, LockableQueue<Chunk> &outputBuffer, int32_t dataVersion) {
 
 	size_t dataLen = 0;
 	uint8_t* data = Binary::load(filename, dataLen);
@@ -38,7 +38,7 @@ void Region::loadMCAtoBuffer(const std::string& filename, int x, int z, const vf
 
 				if (sectorCount == 0) {
 					if (toBeModified) {
-						inputBuffer.push(Chunk::create(chunkType::VANILLA, (int)chunPos.x, (int)chunPos.z));
+						inputBuffer.push(Chunk::create(chunkType::VANILLA, (int)chunPos.x, (int)chunPos.z, dataVersion));
 					}		
 				} else {
 
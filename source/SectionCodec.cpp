@@ -0,0 +1,211 @@
+#include <SectionCodec.hpp>
+
+#include <ChunkSchema.hpp>
+
+
+template<ChunkLayout>
+struct SectionLayout;
+
+template<>
+struct SectionLayout<ChunkLayout::Level> {
+	static const int8_t minSectionY = 0, maxSectionY = 16;
+
+	static NBTcompound& level(NBTcompound& root) {
+		return ChunkSchema::Level.getOrInsert(root);
+	}
+
+	static NBTlist& sections(NBTcompound& level) {
+		return ChunkSchema::Sections.getOrInsert(level);
+	}
+
+	static NBTlist* findPalette(NBTcompound& section) {
+		return ChunkSchema::Palette.find(section);
+	}
+
+	static NBTlongArray* findBlockStates(NBTcompound& section) {
+		return ChunkSchema::BlockStates.find(section);
+	}
+
+	static NBTlist& getOrInsertPalette(NBTcompound& section) {
+		return ChunkSchema::Palette.getOrInsert(section);
+	}
+
+	static NBTlongArray& getOrInsertBlockStates(NBTcompound& section) {
+		return ChunkSchema::BlockStates.getOrInsert(section);
+	}
+
+	static uint32_t bitsPerBlock(size_t paletteSize) {
+		uint32_t bits = 4;
+		while ((1ULL << bits) < paletteSize) bits++;
+		return bits;
+	}
+};
+
+template<>
+struct SectionLayout<ChunkLayout::Flattened> {
+	static const int8_t minSectionY = -4, maxSectionY = 20;
+
+	static NBTcompound& level(NBTcompound& root) {
+		return root;
+	}
+
+	static NBTlist& sections(NBTcompound& level) {
+		return ChunkSchema::sections.getOrInsert(level);
+	}
+
+	static NBTlist* findPalette(NBTcompound& section) {
+		NBTcompound* blockStates = ChunkSchema::block_states.find(section);
+		return blockStates ? ChunkSchema::palette.find(*blockStates) : nullptr;
+	}
+
+	static NBTlongArray* findBlockStates(NBTcompound& section) {
+		NBTcompound* blockStates = ChunkSchema::block_states.find(section);
+		return blockStates ? ChunkSchema::data.find(*blockStates) : nullptr;
+	}
+
+	static NBTlist& getOrInsertPalette(NBTcompound& section) {
+		return ChunkSchema::palette.getOrInsert(ChunkSchema::block_states.getOrInsert(section));
+	}
+
+	static NBTlongArray& getOrInsertBlockStates(NBTcompound& section) {
+		return ChunkSchema::data.getOrInsert(ChunkSchema::block_states.getOrInsert(section));
+	}
+
+	// a single entry palette needs no data at all
+	static uint32_t bitsPerBlock(size_t paletteSize) {
+		if (paletteSize <= 1)
+			return 0;
+		uint32_t bits = 4;
+		while ((1ULL << bits) < paletteSize) bits++;
+		return bits;
+	}
+};
+
+
+template<ChunkLayout layout, BlockStatesPacking packing>
+class SectionCodecImpl : public SectionCodec {
+private:
+	using Layout = SectionLayout<layout>;
+	using Codec = BlockStatesCodec<packing>;
+
+	static void checkSize(const NBTlongArray& blockStates, size_t paletteSize, uint32_t bits) {
+		if (blockStates.size() != Codec::numLongs(bits))
+			throw std::runtime_error("[section_error] expected " + std::to_string(Codec::numLongs(bits)) +
+				" block state longs for " + std::to_string(paletteSize) + " palette entries but found " + std::to_string(blockStates.size()));
+	}
+
+public:
+	SectionCodecImpl() : SectionCodec{ Layout::minSectionY, Layout::maxSectionY } {}
+
+	NBTcompound& level(NBTcompound& root) const override {
+		return Layout::level(root);
+	}
+
+	NBTlist& sections(NBTcompound& level) const override {
+		return Layout::sections(level);
+	}
+
+	NBTlist* findPalette(NBTcompound& section) const override {
+		return Layout::findPalette(section);
+	}
+
+	NBTlongArray* findBlockStates(NBTcompound& section) const override {
+		return Layout::findBlockStates(section);
+	}
+
+	NBTlist& getOrInsertPalette(NBTcompound& section) const override {
+		return Layout::getOrInsertPalette(section);
+	}
+
+	NBTlongArray& getOrInsertBlockStates(NBTcompound& section) const override {
+		return Layout::getOrInsertBlockStates(section);
+	}
+
+	uint32_t bitsPerBlock(size_t paletteSize) const override {
+		return Layout::bitsPerBlock(paletteSize);
+	}
+
+	size_t numLongs(size_t paletteSize) const override {
+		const uint32_t bits = bitsPerBlock(paletteSize);
+		return bits == 0 ? 0 : Codec::numLongs(bits);
+	}
+
+	void unpack(const NBTlongArray& blockStates, size_t paletteSize, uint16_t* indices) const override {
+		const uint32_t bits = bitsPerBlock(paletteSize);
+
+		// empty block states only occur in sections that hold nothing but the first palette entry
+		if (bits == 0 || blockStates.empty()) {
+			std::fill(indices, indices + 4096, 0);
+			return;
+		}
+
+		checkSize(blockStates, paletteSize, bits);
+
+		if constexpr (packing == BlockStatesPacking::Padded) {
+			if (Codec::unpackAVX2(blockStates.data(), bits, indices))
+				return;
+		}
+
+		withBitsPerBlock(bits, [&](auto bitsPerBlock) {
+			Codec::unpack(blockStates.data(), bitsPerBlock, indices);
+		});
+	}
+
+	void pack(const uint16_t* indices, size_t paletteSize, NBTlongArray& blockStates) const override {
+		const uint32_t bits = bitsPerBlock(paletteSize);
+
+		if (bits == 0) {
+			blockStates.clear();
+			return;
+		}
+
+		blockStates.resize(Codec::numLongs(bits));
+		if constexpr (packing == BlockStatesPacking::Padded) {
+			if (Codec::packAVX2(indices, bits, blockStates.data()))
+				return;
+		}
+
+		withBitsPerBlock(bits, [&](auto bitsPerBlock) {
+			Codec::pack(indices, bitsPerBlock, blockStates.data());
+		});
+	}
+
+	void get(const NBTlongArray& blockStates, size_t paletteSize, const uint16_t* positions, size_t count, uint16_t* indices) const override {
+		const uint32_t bits = bitsPerBlock(paletteSize);
+
+		if (bits == 0 || blockStates.empty()) {
+			std::fill(indices, indices + count, 0);
+			return;
+		}
+
+		checkSize(blockStates, paletteSize, bits);
+
+		for (size_t i = 0; i < count; i++)
+			indices[i] = Codec::get(blockStates.data(), bits, positions[i]);
+	}
+
+	void set(NBTlongArray& blockStates, size_t paletteSize, const uint16_t* positions, const uint16_t* indices, size_t count) const override {
+		const uint32_t bits = bitsPerBlock(paletteSize);
+
+		// without data every index is 0, which is the only one a palette of this size allows
+		if (bits == 0)
+			return;
+
+		checkSize(blockStates, paletteSize, bits);
+
+		for (size_t i = 0; i < count; i++)
+			Codec::set(blockStates.data(), bits, positions[i], indices[i]);
+	}
+};
+
+
+const SectionCodec* SectionCodec::forDataVersion(int32_t dataVersion) {
+	static const SectionCodecImpl<ChunkLayout::Level, BlockStatesPacking::Spanning> spanning;
+	static const SectionCodecImpl<ChunkLayout::Level, BlockStatesPacking::Padded> padded;
+	static const SectionCodecImpl<ChunkLayout::Flattened, BlockStatesPacking::Padded> flattened;
+
+	if (dataVersion >= 2844)	return &flattened;	// 21w43a
+	if (dataVersion >= 2529)	return &padded;		// 20w17a
+	if (dataVersion >= 1451)	return &spanning;	// 17w47a, first version with block palettes
+	return nullptr;
+}
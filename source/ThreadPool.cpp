@@ -0,0 +1,97 @@
+#include <ThreadPool.hpp>
+
+
+ThreadPool::ThreadPool(uint32_t numThreads) {
+	threads.reserve(numThreads);
+	for (uint32_t i = 0; i < numThreads; i++)
+		threads.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		stopping = true;
+	}
+	wakeup.notify_all();
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+void ThreadPool::run(Loop& loop) {
+	size_t index;
+	while ((index = loop.next++) < loop.count) {
+		try {
+			loop.function(index);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(loop.mtx);
+			if (!loop.error)
+				loop.error = std::current_exception();
+		}
+
+		if (++loop.finished == loop.count) {
+			std::lock_guard<std::mutex> lock(loop.mtx);
+			loop.done.notify_all();
+		}
+	}
+}
+
+void ThreadPool::work() {
+	while (true) {
+		std::shared_ptr<Loop> loop;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			wakeup.wait(lock, [this]() { return stopping || !loops.empty(); });
+
+			if (loops.empty())
+				return;
+
+			loop = loops.front();
+		}
+
+		run(*loop);
+
+		// every index is taken, the loop is finished by whoever holds the last ones
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!loops.empty() && loops.front() == loop)
+			loops.pop_front();
+	}
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& function) {
+	if (count == 0)
+		return;
+
+	std::shared_ptr<Loop> loop = std::make_shared<Loop>();
+	loop->function = function;
+	loop->count = count;
+
+	if (count > 1 && !threads.empty()) {
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			loops.push_back(loop);
+		}
+		wakeup.notify_all();
+	}
+
+	run(*loop);
+
+	{
+		std::unique_lock<std::mutex> lock(loop->mtx);
+		loop->done.wait(lock, [&loop]() { return loop->finished == loop->count; });
+	}
+
+	// nobody else may have taken it off the queue yet
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto it = loops.begin(); it != loops.end(); it++) {
+			if (*it == loop) {
+				loops.erase(it);
+				break;
+			}
+		}
+	}
+
+	if (loop->error)
+		std::rethrow_exception(loop->error);
+}
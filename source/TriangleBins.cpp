@@ -0,0 +1,142 @@
+#include <TriangleBins.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+
+static void parallelFor(uint32_t count, uint32_t numThreads, const std::function<void(uint32_t, uint32_t)>& body) {
+	const uint32_t chunkSize = (count + numThreads - 1) / numThreads;
+	std::vector<std::thread> threads;
+	for (uint32_t begin = 0; begin < count; begin += chunkSize)
+		threads.emplace_back(body, begin, std::min(begin + chunkSize, count));
+	for (auto& thread : threads)
+		thread.join();
+}
+
+TriangleBins::TriangleBins(const mcBoundingBox& workingVolume, uint32_t numTriangles, const BoundsFunction& bounds, uint32_t numThreads) :
+	minChunkX{ workingVolume.minChunkX }, minChunkZ{ workingVolume.minChunkZ }, minSectionY{ workingVolume.minSectionY },
+	// chunks on the upper edge are loaded as well, so they get their own cells
+	numChunksX{ workingVolume.maxChunkX - workingVolume.minChunkX + 1 },
+	numChunksZ{ workingVolume.maxChunkZ - workingVolume.minChunkZ + 1 },
+	numSectionsY{ std::max(workingVolume.maxSectionY - workingVolume.minSectionY, 0) } {
+
+	numThreads = std::max(numThreads, 1U);
+
+	const size_t numCells = static_cast<size_t>(numChunksX) * numChunksZ * numSectionsY;
+
+	// cell ranges per triangle, bounds are closed like approxTriBoxOverlap, so a triangle touching
+	// a cell border is binned into both cells
+	struct CellBox { int min[3], max[3]; };
+	std::vector<CellBox> cellBoxes(numTriangles);
+
+	const int gridMin[3] = { minChunkX, minSectionY, minChunkZ };
+	const int gridMax[3] = { minChunkX + numChunksX - 1, minSectionY + numSectionsY - 1, minChunkZ + numChunksZ - 1 };
+
+	std::unique_ptr<std::atomic<uint32_t>[]> counts(new std::atomic<uint32_t>[numCells]);
+	for (size_t i = 0; i < numCells; i++)
+		counts[i].store(0, std::memory_order_relaxed);
+
+	const auto forEachCell = [&](const CellBox& box, const auto& callback) {
+		for (int y = box.min[1]; y <= box.max[1]; y++)
+			for (int z = box.min[2]; z <= box.max[2]; z++)
+				for (int x = box.min[0]; x <= box.max[0]; x++)
+					callback(static_cast<size_t>(cellIndex(x, z, y)));
+	};
+
+	//------------------------/ count /------------------------//
+
+	parallelFor(numTriangles, numThreads, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			vf3 min, max;
+			bounds(i, min, max);
+
+			const float lower[3] = { min.x, min.y, min.z };
+			const float upper[3] = { max.x, max.y, max.z };
+
+			CellBox& box = cellBoxes[i];
+			for (int axis = 0; axis < 3; axis++) {
+				box.min[axis] = std::max(static_cast<int>(std::ceil(lower[axis] / 16.0f)) - 1, gridMin[axis]);
+				box.max[axis] = std::min(static_cast<int>(std::floor(upper[axis] / 16.0f)), gridMax[axis]);
+			}
+
+			forEachCell(box, [&](size_t cell) {
+				counts[cell].fetch_add(1, std::memory_order_relaxed);
+			});
+		}
+	});
+
+	//------------------------/ prefix sum /------------------------//
+
+	offsets.resize(numCells + 1);
+	offsets[0] = 0;
+	for (size_t i = 0; i < numCells; i++) {
+		offsets[i + 1] = offsets[i] + counts[i].load(std::memory_order_relaxed);
+		counts[i].store(offsets[i], std::memory_order_relaxed);
+	}
+
+	//------------------------/ fill /------------------------//
+
+	indices.resize(offsets[numCells]);
+
+	parallelFor(numTriangles, numThreads, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			forEachCell(cellBoxes[i], [&](size_t cell) {
+				indices[counts[cell].fetch_add(1, std::memory_order_relaxed)] = i;
+			});
+		}
+	});
+
+	// threads fill the cells in arbitrary order, the first triangle has to come first again
+	parallelFor(static_cast<uint32_t>(numCells), numThreads, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t cell = begin; cell < end; cell++)
+			std::sort(indices.begin() + offsets[cell], indices.begin() + offsets[cell + 1]);
+	});
+}
+
+int64_t TriangleBins::cellIndex(int chunkX, int chunkZ, int sectionY) const {
+	const int x = chunkX - minChunkX;
+	const int z = chunkZ - minChunkZ;
+	const int y = sectionY - minSectionY;
+
+	if (x < 0 || x >= numChunksX || z < 0 || z >= numChunksZ || y < 0 || y >= numSectionsY)
+		return -1;
+
+	return (static_cast<int64_t>(z) * numChunksX + x) * numSectionsY + y;
+}
+
+TriangleBins::Range TriangleBins::section(int chunkX, int chunkZ, int sectionY) const {
+	const int64_t cell = cellIndex(chunkX, chunkZ, sectionY);
+	if (cell < 0)
+		return { nullptr, nullptr };
+
+	return { indices.data() + offsets[cell], indices.data() + offsets[cell + 1] };
+}
+
+void TriangleBins::column(int chunkX, int chunkZ, std::vector<uint32_t>& out) const {
+	const size_t offset = out.size();
+
+	for (int sectionY = minSectionY; sectionY < minSectionY + numSectionsY; sectionY++) {
+		const Range range = section(chunkX, chunkZ, sectionY);
+		out.insert(out.end(), range.begin(), range.end());
+	}
+
+	std::sort(out.begin() + offset, out.end());
+	out.erase(std::unique(out.begin() + offset, out.end()), out.end());
+}
+
+std::pair<int, int> TriangleBins::sectionRange(int chunkX, int chunkZ) const {
+	int first = minSectionY + numSectionsY;
+	int last = minSectionY;
+
+	for (int sectionY = minSectionY; sectionY < minSectionY + numSectionsY; sectionY++) {
+		if (!section(chunkX, chunkZ, sectionY).empty()) {
+			first = std::min(first, sectionY);
+			last = sectionY + 1;
+		}
+	}
+
+	return first < last ? std::make_pair(first, last) : std::make_pair(first, first);
+}
@@ -0,0 +1,146 @@
+#include <TriangleBoxBatch.hpp>
+
+#include <CPUFeatures.hpp>
+
+#ifdef CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+// The vector kernels repeat the operations of PreparedTriangle::overlapsVoxel lane by lane
+// (no fused multiply-add), the early outs become a rejection mask.
+
+namespace TriangleBoxBatch {
+
+	void scalar(const PreparedTriangle& triangle, const float* centerX, const float* centerY, const float* centerZ, size_t count, uint8_t* overlaps) {
+		for (size_t i = 0; i < count; i++)
+			overlaps[i] = triangle.overlapsVoxel(vf3(centerX[i], centerY[i], centerZ[i]));
+	}
+
+#ifdef CPU_FEATURES_X86
+
+	//--------------/ avx2 /--------------//
+
+	TARGET_AVX2 static inline __m256 outside256(__m256 q, float lower, float upper) {
+		return _mm256_or_ps(
+			_mm256_cmp_ps(q, _mm256_set1_ps(lower), _CMP_LT_OQ),
+			_mm256_cmp_ps(q, _mm256_set1_ps(upper), _CMP_GT_OQ)
+		);
+	}
+
+	TARGET_AVX2 void avx2(const PreparedTriangle& triangle, const float* centerX, const float* centerY, const float* centerZ, size_t count, uint8_t* overlaps) {
+		const __m256 nx = _mm256_set1_ps(triangle.normal.x);
+		const __m256 ny = _mm256_set1_ps(triangle.normal.y);
+		const __m256 nz = _mm256_set1_ps(triangle.normal.z);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			const __m256 c[3] = {
+				_mm256_loadu_ps(centerX + i),
+				_mm256_loadu_ps(centerY + i),
+				_mm256_loadu_ps(centerZ + i)
+			};
+
+			__m256 reject = outside256(c[0], triangle.extentLower.x, triangle.extentUpper.x);
+			reject = _mm256_or_ps(reject, outside256(c[1], triangle.extentLower.y, triangle.extentUpper.y));
+			reject = _mm256_or_ps(reject, outside256(c[2], triangle.extentLower.z, triangle.extentUpper.z));
+
+			for (int edge = 0; edge < 3; edge++) {
+				for (int k = 0; k < 3; k++) {
+					const PreparedTriangle::Axis& axis = triangle.edgeAxes[edge * 3 + k];
+					const __m256 q = _mm256_sub_ps(
+						_mm256_mul_ps(_mm256_set1_ps(axis.a), c[(k + 1) % 3]),
+						_mm256_mul_ps(_mm256_set1_ps(axis.b), c[(k + 2) % 3])
+					);
+					reject = _mm256_or_ps(reject, outside256(q, axis.lower, axis.upper));
+				}
+			}
+
+			const __m256 q = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, c[0]), _mm256_mul_ps(ny, c[1])), _mm256_mul_ps(nz, c[2]));
+			reject = _mm256_or_ps(reject, outside256(q, triangle.planeLower, triangle.planeUpper));
+
+			const int mask = _mm256_movemask_ps(reject);
+			for (int lane = 0; lane < 8; lane++)
+				overlaps[i + lane] = !((mask >> lane) & 1);
+		}
+
+		scalar(triangle, centerX + i, centerY + i, centerZ + i, count - i, overlaps + i);
+	}
+
+
+	//--------------/ avx512 /--------------//
+
+	TARGET_AVX512 static inline __mmask16 outside512(__m512 q, float lower, float upper) {
+		return _mm512_cmp_ps_mask(q, _mm512_set1_ps(lower), _CMP_LT_OQ) |
+			_mm512_cmp_ps_mask(q, _mm512_set1_ps(upper), _CMP_GT_OQ);
+	}
+
+	TARGET_AVX512 void avx512(const PreparedTriangle& triangle, const float* centerX, const float* centerY, const float* centerZ, size_t count, uint8_t* overlaps) {
+		const __m512 nx = _mm512_set1_ps(triangle.normal.x);
+		const __m512 ny = _mm512_set1_ps(triangle.normal.y);
+		const __m512 nz = _mm512_set1_ps(triangle.normal.z);
+
+		for (size_t i = 0; i < count; i += 16) {
+			// the tail is handled with masked loads instead of a scalar loop
+			const size_t numLanes = count - i >= 16 ? 16 : count - i;
+			const __mmask16 active = static_cast<__mmask16>((1U << numLanes) - 1);
+
+			const __m512 c[3] = {
+				_mm512_maskz_loadu_ps(active, centerX + i),
+				_mm512_maskz_loadu_ps(active, centerY + i),
+				_mm512_maskz_loadu_ps(active, centerZ + i)
+			};
+
+			__mmask16 reject = outside512(c[0], triangle.extentLower.x, triangle.extentUpper.x);
+			reject |= outside512(c[1], triangle.extentLower.y, triangle.extentUpper.y);
+			reject |= outside512(c[2], triangle.extentLower.z, triangle.extentUpper.z);
+
+			for (int edge = 0; edge < 3; edge++) {
+				for (int k = 0; k < 3; k++) {
+					const PreparedTriangle::Axis& axis = triangle.edgeAxes[edge * 3 + k];
+					const __m512 q = _mm512_sub_ps(
+						_mm512_mul_ps(_mm512_set1_ps(axis.a), c[(k + 1) % 3]),
+						_mm512_mul_ps(_mm512_set1_ps(axis.b), c[(k + 2) % 3])
+					);
+					reject |= outside512(q, axis.lower, axis.upper);
+				}
+			}
+
+			const __m512 q = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(nx, c[0]), _mm512_mul_ps(ny, c[1])), _mm512_mul_ps(nz, c[2]));
+			reject |= outside512(q, triangle.planeLower, triangle.planeUpper);
+
+			for (size_t lane = 0; lane < numLanes; lane++)
+				overlaps[i + lane] = !((reject >> lane) & 1);
+		}
+	}
+
+#else
+
+	void avx2(const PreparedTriangle& triangle, const float* centerX, const float* centerY, const float* centerZ, size_t count, uint8_t* overlaps) {
+		scalar(triangle, centerX, centerY, centerZ, count, overlaps);
+	}
+
+	void avx512(const PreparedTriangle& triangle, const float* centerX, const float* centerY, const float* centerZ, size_t count, uint8_t* overlaps) {
+		scalar(triangle, centerX, centerY, centerZ, count, overlaps);
+	}
+
+#endif
+
+	//--------------/ dispatch /--------------//
+
+	Kernel select() {
+		const CPUFeatures::Features& features = CPUFeatures::get();
+		if (features.avx512f)
+			return avx512;
+		if (features.avx2)
+			return avx2;
+		return scalar;
+	}
+
+	const char* name(Kernel kernel) {
+		if (kernel == avx512)
+			return "avx512";
+		if (kernel == avx2)
+			return "avx2";
+		return "scalar";
+	}
+}
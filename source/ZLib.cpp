@@ -64,6 +64,115 @@ uint8_t* ZLib::uncompress(uint8_t* input, size_t& inputSize) {
 	return output;
 }
 
+ZLib::DeflateWriter::DeflateWriter() : stream(new z_stream{}), output(new uint8_t[blockSize]), outputSize(blockSize) {
+	buffer = new uint8_t[blockSize];
+	bufferSize = blockSize;
+
+	int status = deflateInit(stream, Z_DEFAULT_COMPRESSION);
+	if (status != Z_OK) {
+		delete stream;
+		delete[] output;
+		delete[] buffer;
+		throw std::runtime_error("[compression_error] " + errorToString(status));
+	}
+
+	stream->next_out = (Bytef*)output;
+	stream->avail_out = (uInt)outputSize;
+}
+
+ZLib::DeflateWriter::~DeflateWriter() {
+	deflateEnd(stream);
+	delete stream;
+	delete[] output;
+	delete[] buffer;
+}
+
+void ZLib::DeflateWriter::deflateBlock(int flush) {
+	stream->next_in = (Bytef*)buffer;
+	stream->avail_in = (uInt)index;
+
+	int status;
+	do {
+		if (stream->avail_out == 0) {
+			uint8_t* newOutput = new uint8_t[outputSize * 2];
+			memcpy(newOutput, output, outputSize);
+			delete[] output;
+
+			output = newOutput;
+			stream->next_out = (Bytef*)&output[outputSize];
+			stream->avail_out = (uInt)outputSize;
+			outputSize *= 2;
+		}
+
+		status = deflate(stream, flush);
+		if (status == Z_STREAM_ERROR)
+			throw std::runtime_error("[compression_error] " + errorToString(status));
+
+	} while (stream->avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+
+	index = 0;
+}
+
+void ZLib::DeflateWriter::overflow(size_t) {
+	deflateBlock(Z_NO_FLUSH);
+}
+
+uint8_t* ZLib::DeflateWriter::finish(size_t& size) {
+	deflateBlock(Z_FINISH);
+
+	size = stream->total_out;
+	uint8_t* data = output;
+
+	output = nullptr;
+	outputSize = 0;
+
+	return data;
+}
+
+ZLib::InflateReader::InflateReader(const uint8_t* input, size_t inputSize) : stream(new z_stream{}), block(new uint8_t[blockSize]), finished(false) {
+	buffer = block;
+
+	int status = inflateInit(stream);
+	if (status != Z_OK) {
+		delete stream;
+		delete[] block;
+		throw std::runtime_error("[decompression_error] " + errorToString(status));
+	}
+
+	stream->next_in = (Bytef*)input;
+	stream->avail_in = (uInt)inputSize;
+}
+
+ZLib::InflateReader::~InflateReader() {
+	inflateEnd(stream);
+	delete stream;
+	delete[] block;
+}
+
+void ZLib::InflateReader::underflow(size_t required) {
+	const size_t remaining = bufferSize - index;
+	memmove(block, &block[index], remaining);
+	index = 0;
+	bufferSize = remaining;
+
+	while (bufferSize < required) {
+		if (finished)
+			throw std::out_of_range("[decompression_error] unexpected end of stream after " + std::to_string(stream->total_out) + " bytes");
+
+		stream->next_out = (Bytef*)&block[bufferSize];
+		stream->avail_out = (uInt)(blockSize - bufferSize);
+
+		int status = inflate(stream, Z_NO_FLUSH);
+		if (status == Z_STREAM_END) {
+			finished = true;
+		} else if (status != Z_OK) {
+			throw std::runtime_error("[decompression_error] " + errorToString(status));
+		}
+
+		bufferSize = blockSize - stream->avail_out;
+	}
+}
+
 std::string ZLib::errorToString(int status) {
 	std::string type = "[zlib_error] ";
 	switch (status) {
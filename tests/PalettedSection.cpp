@@ -0,0 +1,97 @@
+// Checks for PalettedSection::apply, a standalone program that returns 0 if every check passes:
+// g++ -std=c++17 -Iinclude tests/PalettedSection.cpp source/PalettedSection.cpp source/ChunkSchema.cpp source/SectionCodec.cpp
+//     source/BlockStatesCodec.cpp source/BlockRegistry.cpp source/InternedString.cpp source/NBT.cpp source/Logger.cpp -lz
+
+#include <PalettedSection.hpp>
+#include <BlockRegistry.hpp>
+
+#include <iostream>
+#include <string>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "[failed] " << message << std::endl;
+		failures++;
+	}
+}
+
+// 1.18+ section whose palette holds a single block and that therefore has no "data"
+static NBTcompound paletteOnlyChunk(int8_t y, const char* block) {
+	return NBTcompound{
+		{ "sections", NBTlist{
+			NBTcompound{
+				{ "Y", y },
+				{ "block_states", NBTcompound{
+					{ "palette", NBTlist{ NBTcompound{ { "Name", NBTstring(block) } } } }
+				} }
+			}
+		} }
+	};
+}
+
+static void paletteOnlySection() {
+	const uint16_t air = BlockRegistry::id("minecraft:air");
+	const uint16_t stone = BlockRegistry::id("minecraft:stone");
+
+	NBTcompound root = paletteOnlyChunk(5, "minecraft:air");
+	ChunkSections sections(root, *SectionCodec::forDataVersion(3465));
+
+	SectionPatch unchanged;
+	unchanged.push(7, air);
+	check(!PalettedSection::apply(sections, 5, unchanged, air), "air written to an air section changes it");
+
+	SectionPatch patch;
+	patch.push(7, stone);
+	check(PalettedSection::apply(sections, 5, patch, air), "stone written to an air section leaves it unchanged");
+
+	ChunkSections::Section* section = sections.find(5);
+	check(section && section->palette->size() == 2, "palette of the patched section is not [air, stone]");
+	check(section && section->blockStates && !section->blockStates->empty(), "patched section has no block states");
+
+	PalettedSection decoded(sections, *section, air);
+	for (size_t i = 0; i < 4096; i++) {
+		if (decoded.blockID(i) != (i == 7 ? stone : air)) {
+			check(false, "block " + std::to_string(i) + " holds the wrong block after the patch");
+			break;
+		}
+	}
+}
+
+static void overwrittenBlockLeavesPalette() {
+	const uint16_t air = BlockRegistry::id("minecraft:air");
+	const uint16_t stone = BlockRegistry::id("minecraft:stone");
+	const uint16_t dirt = BlockRegistry::id("minecraft:dirt");
+
+	for (const int32_t dataVersion : { 2230, 2586, 3465 }) {
+		NBTcompound root;
+		ChunkSections sections(root, *SectionCodec::forDataVersion(dataVersion));
+		const std::string layout = " (DataVersion " + std::to_string(dataVersion) + ")";
+
+		SectionPatch fill;
+		for (uint16_t i = 0; i < 4096; i++)
+			fill.push(i, i == 100 ? dirt : stone);
+		check(PalettedSection::apply(sections, 2, fill, air), "filling a new section leaves it unchanged" + layout);
+
+		SectionPatch patch;
+		patch.push(100, stone);
+		check(PalettedSection::apply(sections, 2, patch, air), "overwriting the only dirt block leaves the section unchanged" + layout);
+
+		ChunkSections::Section* section = sections.find(2);
+		check(section && section->palette->size() == 1, "the palette still holds dirt after its last block was overwritten" + layout);
+
+		PalettedSection decoded(sections, *section, air);
+		check(decoded.blockID(100) == stone && decoded.blockID(0) == stone, "the overwritten section does not hold stone" + layout);
+	}
+}
+
+int main() {
+	paletteOnlySection();
+	overwrittenBlockLeavesPalette();
+
+	if (failures == 0)
+		std::cout << "all checks passed" << std::endl;
+
+	return failures == 0 ? 0 : 1;
+}